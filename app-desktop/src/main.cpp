@@ -56,10 +56,14 @@ int main()
     // Random seed
     srand(unsigned(time(NULL)));
 
-    // Initialize application
+    // Initialize application, drawing to the framebuffer which is larger than the window on high density screens
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
     application = new Application();
     application->setup({
-        .rootPath = "lib"
+        .rootPath = "lib",
+        .width    = width,
+        .height   = height
     });
 
     // Create a draw and update thread
@@ -3,4 +3,6 @@
 struct ApplicationParams
 {
     const char* rootPath;
+    int width; // Of the window's framebuffer, in pixels
+    int height;
 };
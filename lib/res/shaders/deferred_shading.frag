@@ -3,19 +3,30 @@
 out vec4 frag_coords;
 in vec2 text_coords;
 
-uniform sampler2D g_position;
-uniform sampler2D g_normal;
+uniform sampler2D g_depth;
+uniform sampler2D g_normal;   // octahedral encoded
 uniform sampler2D g_diffuse;
-uniform sampler2D g_mr;
-uniform sampler2D g_shadow;
+uniform sampler2D g_material; // metallicness, roughness, shadow
+uniform mat4 inverse_view_projection;
 
 uniform samplerCube environment;
 uniform samplerCube irradiance_map;
 
-uniform vec3 view_position;
-uniform vec3 ambiant_color;
-uniform vec3 direct_light_color;
-uniform vec3 direct_light_direction;
+layout(std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+    vec4 camera_position;
+    vec4 frustum_planes[6];
+};
+
+layout(std140) uniform Light
+{
+    vec4 light_direction; // direction the light travels
+    vec4 light_color;
+    vec4 ambiant_color;
+};
 
 uniform float gamma;
 
@@ -28,6 +39,7 @@ vec3 rgb2hsv(vec3 c);
 vec3 artisticShading(vec3 diffuse_color, vec3 light_direction, vec3 surface_normal);
 vec3 globalIllumination(vec3 reflection, float roughness);
 vec3 simpleReinhardToneMapping(vec3 color, float gamma);
+vec3 octahedralDecode(vec2 e);
 
 
 // ================================
@@ -35,15 +47,21 @@ vec3 simpleReinhardToneMapping(vec3 color, float gamma);
 
 void main ()
 {
+    vec3 view_position          = camera_position.xyz;
+    vec3 direct_light_color     = light_color.rgb;
+    vec3 direct_light_direction = -light_direction.xyz;
 
 // ---- retrieve data from gbuffer
 
-    vec3  fragment_position = texture(g_position, text_coords).rgb;
-    vec3  surface_normal    = texture(g_normal, text_coords).rgb;
+    float depth             = texture(g_depth, text_coords).r;
+    vec4  clip_position     = inverse_view_projection * vec4(vec3(text_coords, depth) * 2. - 1., 1.);
+    vec3  fragment_position = clip_position.xyz / max(clip_position.w, 1e-6); // w is 0 where nothing was drawn
+    vec3  surface_normal    = octahedralDecode(texture(g_normal, text_coords).rg);
     vec3  diffuse           = texture(g_diffuse, text_coords).rgb;
-    float metallicness      = texture(g_mr, text_coords).r;
-    float roughness         = max(texture(g_mr, text_coords).g, 0.0001);
-    float shadow            = texture(g_shadow, text_coords).r;
+    vec3  material          = texture(g_material, text_coords).rgb;
+    float metallicness      = material.r;
+    float roughness         = max(material.g, 0.0001);
+    float shadow            = material.b;
 
 // ---- pre-compute data
 
@@ -78,7 +96,7 @@ void main ()
 
 // ---- output
 
-    frag_coords = vec4(final_color, 1.0);
+    frag_coords = vec4(depth < 1. ? final_color : vec3(0.), 1.0);
 }
 
 // ================================
@@ -114,6 +132,18 @@ vec3 hsv2rgb(vec3 c)
     return c.z * mix(K.xxx, clamp(p - K.xxx, 0.0, 1.0), c.y);
 }
 
+// ================================
+// Unit vector folded on the octahedron, see geometry_buffer.frag
+// ================================
+
+vec3 octahedralDecode(vec2 e)
+{
+    e = e * 2. - 1.;
+    vec3 n = vec3(e, 1. - abs(e.x) - abs(e.y));
+    if (n.z < 0.) n.xy = (1. - abs(n.yx)) * vec2(n.x >= 0. ? 1. : -1., n.y >= 0. ? 1. : -1.);
+    return normalize(n);
+}
+
 // ================================
 // https://www.shadertoy.com/view/Xtj3Dm
 // ================================
@@ -121,7 +151,7 @@ vec3 hsv2rgb(vec3 c)
 vec3 artisticShading(vec3 diffuse_color, vec3 light_direction, vec3 surface_normal)
 {
     vec3  hsv = rgb2hsv(diffuse_color);
-    float nl = clamp(dot(surface_normal, direct_light_direction), 0., 1.);
+    float nl = clamp(dot(surface_normal, light_direction), 0., 1.);
     float vari = sin(nl * 6.28 * 0.5 - 1.5708);
     hsv.x += (nl - 0.7) * 0.08; //Hue variation
     hsv.y += vari * 0.1;        //Saturation variation
@@ -1,12 +1,18 @@
 #version 330
 
 layout (location = 0) in vec4 position;
-layout (location = 5) in mat4 model;  // 4-7
+layout (location = 5) in mat3x4 model;  // 5-7, one row per column
 
-uniform mat4 view;
-uniform mat4 projection;
+layout(std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+    vec4 camera_position;
+    vec4 frustum_planes[6];
+};
 
 void main(void)
 {
-    gl_Position = projection * view * model * position;
+    gl_Position = view_projection * vec4(position * model, 1.0);
 }
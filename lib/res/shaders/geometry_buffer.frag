@@ -1,39 +1,47 @@
 #version 330 core
 
-layout (location = 0) out vec3 gPosition;
-layout (location = 1) out vec3 gNormal;
-layout (location = 2) out vec3 gDiffuse;
-layout (location = 3) out vec3 gMRS;
+layout (location = 0) out vec2 gNormal;
+layout (location = 1) out vec3 gDiffuse;
+layout (location = 2) out vec4 gMaterial;
 
 in vec2 TexCoords;
-in vec3 FragPos;
 in vec3 Normal;
 in vec3 Tangent;
 in vec3 Bitangent;
+flat in float Layer;
 
-uniform sampler2D texture_diffuse;
-uniform sampler2D texture_metallic;
-uniform sampler2D texture_rough;
-uniform sampler2D texture_normal;
+uniform sampler2DArray texture_diffuse;
+uniform sampler2DArray texture_metallic;
+uniform sampler2DArray texture_rough;
+uniform sampler2DArray texture_normal;
+
+// Unit vector folded on the octahedron then unfolded on a square, in [0, 1]
+vec2 octahedralEncode(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 folded = n.z >= 0. ? n.xy : (1. - abs(n.yx)) * vec2(n.x >= 0. ? 1. : -1., n.y >= 0. ? 1. : -1.);
+    return folded * 0.5 + 0.5;
+}
 
 void main()
 {
-	mat3 TBN = mat3(Tangent, Bitangent, Normal);
+    vec3 uvl = vec3(TexCoords, Layer);
 
-    // Store the fragment position
-    gPosition = FragPos;
+	mat3 TBN = mat3(Tangent, Bitangent, Normal);
 
-    // Store the per-fragment normals
-    gNormal.rgb = TBN * normalize(texture(texture_normal, TexCoords).rgb);
+    // Store the per-fragment normals, the position is rebuilt from depth
+    gNormal = octahedralEncode(TBN * normalize(texture(texture_normal, uvl).rgb));
 
     // Store the per-fragment diffuse color
-    gDiffuse.rgb = texture(texture_diffuse, TexCoords).rgb;
+    gDiffuse.rgb = texture(texture_diffuse, uvl).rgb;
 
     // Store the per-fragment metallicness
-    gMRS.r = texture(texture_metallic, TexCoords).r;
+    gMaterial.r = texture(texture_metallic, uvl).r;
 
     // Store the per-fragment roughness
-    gMRS.g = texture(texture_rough, TexCoords).r;
+    gMaterial.g = texture(texture_rough, uvl).r;
 
-    // gMRS.b = ...?
+    // In shadow until the shadow passes find it lit
+    gMaterial.b = 0.;
+    gMaterial.a = 0.;
 }
@@ -5,26 +5,33 @@ layout (location = 1) in vec2 texCoords;
 layout (location = 2) in vec3 normal;
 layout (location = 3) in vec3 tangent;
 layout (location = 4) in vec3 bitangent;
-layout (location = 5) in mat4 model;  // 5-8
+layout (location = 5) in mat3x4 model;  // 5-7, one row per column
+layout (location = 8) in float layer;
 
-out vec3 FragPos;
 out vec2 TexCoords;
 out vec3 Normal;
 out vec3 Tangent;
 out vec3 Bitangent;
+flat out float Layer;
 
-uniform mat4 view;
-uniform mat4 projection;
+layout(std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+    vec4 camera_position;
+    vec4 frustum_planes[6];
+};
 
 void main()
 {
-    vec4 worldPos = model * position;
+    vec4 worldPos = vec4(position * model, 1.0);
 
-    gl_Position = projection * view * model * position;
+    gl_Position = view_projection * worldPos;
 
-    FragPos   = worldPos.xyz;
     TexCoords = texCoords;
-    Normal    = normalize(model * vec4(normal, 0.0)).xyz;
-    Tangent   = normalize(model * vec4(tangent, 0.0)).xyz;
-    Bitangent = normalize(model * vec4(bitangent, 0.0)).xyz;
+    Normal    = normalize(vec4(normal, 0.0) * model);
+    Tangent   = normalize(vec4(tangent, 0.0) * model);
+    Bitangent = normalize(vec4(bitangent, 0.0) * model);
+    Layer     = layer;
 }
@@ -0,0 +1,17 @@
+#version 330
+
+layout(location = 0) in vec4 position; // world space, w = 0 at infinity
+
+layout(std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+    vec4 camera_position;
+    vec4 frustum_planes[6];
+};
+
+void main(void)
+{
+    gl_Position = view_projection * position;
+}
@@ -1,12 +1,9 @@
 #version 330 core
 
-layout (location = 4) out vec3 gShadow;
+layout (location = 0) out vec4 gMaterial; // only blue is written
 
 void main()
 {
     // Store shadow mask
-    gShadow.r = 1.;
-
-    // gShadow.g = ...?
-    // gShadow.b = ...?
+    gMaterial.b = 1.;
 }
@@ -0,0 +1,11 @@
+#version 330
+
+layout (location = 0) in vec4 position;
+layout (location = 5) in mat3x4 model;  // 5-7, one row per column
+
+uniform mat4 light_view_projection;
+
+void main(void)
+{
+    gl_Position = light_view_projection * vec4(position * model, 1.0);
+}
@@ -0,0 +1,66 @@
+#version 330 core
+
+layout (location = 0) out vec4 gMaterial; // only blue is written
+in vec2 text_coords;
+
+uniform sampler2D depth;
+uniform sampler2D g_normal;
+uniform sampler2DArrayShadow shadow_map;
+
+uniform mat4 inverse_view_projection;
+uniform mat4 cascade_matrices[4];
+uniform vec4 cascade_ends;   // view depth where each cascade stops
+uniform vec4 cascade_texels; // world size of the texels of each cascade
+uniform int cascade_count;
+
+layout(std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+    vec4 camera_position;
+    vec4 frustum_planes[6];
+};
+
+vec3 octahedralDecode(vec2 e)
+{
+    e = e * 2. - 1.;
+    vec3 n = vec3(e, 1. - abs(e.x) - abs(e.y));
+    if (n.z < 0.) n.xy = (1. - abs(n.yx)) * vec2(n.x >= 0. ? 1. : -1., n.y >= 0. ? 1. : -1.);
+    return normalize(n);
+}
+
+void main()
+{
+    float d = texture(depth, text_coords).r;
+    vec4 world = inverse_view_projection * vec4(vec3(text_coords, d) * 2. - 1., 1.);
+    vec3 position = world.xyz / world.w;
+    float view_depth = -(view * vec4(position, 1.)).z;
+
+    // Nothing drawn there or past the last cascade, lit as the shadow volumes leave it
+    int cascade = 0;
+    while (cascade < cascade_count && view_depth > cascade_ends[cascade]) cascade ++;
+    if (d >= 1. || cascade == cascade_count) {
+        gMaterial.b = 1.;
+        return;
+    }
+
+    // Looked up a texel and a half off the surface, towards the camera, so
+    // surfaces don't shadow themselves
+    vec3 normal = octahedralDecode(texture(g_normal, text_coords).rg);
+    if (dot(normal, camera_position.xyz - position) < 0.) normal = -normal;
+    vec4 projected = cascade_matrices[cascade] * vec4(position + normal * cascade_texels[cascade] * 1.5, 1.);
+    vec3 coords = projected.xyz * 0.5 + 0.5;
+
+    // 3x3 taps, each filtering 2x2 comparisons
+    vec2 texel = 1. / vec2(textureSize(shadow_map, 0).xy);
+    float lit = 0.;
+    for (int x = -1; x <= 1; x ++) {
+        for (int y = -1; y <= 1; y ++) {
+            lit += texture(shadow_map, vec4(coords.xy + vec2(x, y) * texel, float(cascade), coords.z - 0.0005));
+        }
+    }
+
+    // Store shadow mask
+    gMaterial.b = lit / 9.;
+}
@@ -1,13 +1,13 @@
 #version 330
 
 layout(location = 0) in vec4 position;
-layout(location = 5) in mat4 model;  // 4-7
+layout(location = 5) in mat3x4 model;  // 5-7, one row per column
 
 /* uniform mat4 view; */
 /* uniform mat4 projection; */
 
 void main(void)
 {
-    gl_Position = model * position;
-    /* gl_Position = projection * view * model * position; */
+    gl_Position = vec4(position * model, 1.0);
+    /* gl_Position = projection * view * vec4(position * model, 1.0); */
 }
@@ -13,13 +13,16 @@ Application::~Application()
 
 void Application::setup(ApplicationParams params)
 {
-    game->load(params.rootPath);
+    game->load(params.rootPath, params.width, params.height);
 }
 
 void Application::onKeyPressed(int key)
 {
     switch (key) {
         case 256: running = false; break; // ESC
+        case 86: game->toggleShadowVolumes(); break; // V
+        case 77: game->toggleShadowTechnique(); break; // M
+        case 66: game->benchmarkShadows(); break; // B
     }
 }
 
@@ -5,6 +5,9 @@
 
 #include <utils/Random.hpp>
 #include <utils/Path.hpp>
+#include <utils/Log.hpp>
+#include <utils/ThreadPool.hpp>
+#include <utils/FileWatcher.hpp>
 
 #include <glm/glm.hpp>
 
@@ -15,85 +18,130 @@
 #include <graphic/Mesh.hpp>
 #include <graphic/MeshParams.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace std;
+
 Game::Game()
     : renderSystem(&visibilityComponents, &movementComponents)
     , movementSystem(&movementComponents)
     , renderer(meshStore, programStore, cubemapStore)
+    , meshStreamer(meshStore)
 {
 }
 
-void Game::load(const char* rootPath)
+void Game::load(const char* rootPath, int width, int height)
 {
-    Path root(rootPath);
-
-    // TODO move to a loader?
-    cubemapStore.insert("stormyday", {
-        .right  = root.get("res/textures/environments/stormyday/cubemap/right.png").data(),
-        .left   = root.get("res/textures/environments/stormyday/cubemap/left.png").data(),
-        .bottom = root.get("res/textures/environments/stormyday/cubemap/bottom.png").data(),
-        .top    = root.get("res/textures/environments/stormyday/cubemap/top.png").data(),
-        .back   = root.get("res/textures/environments/stormyday/cubemap/back.png").data(),
-        .front  = root.get("res/textures/environments/stormyday/cubemap/front.png").data() });
-    cubemapStore.insert("stormyday-irradiance-map", {
-        .right  = root.get("res/textures/environments/stormyday/irradiance-map/right.png").data(),
-        .left   = root.get("res/textures/environments/stormyday/irradiance-map/left.png").data(),
-        .bottom = root.get("res/textures/environments/stormyday/irradiance-map/bottom.png").data(),
-        .top    = root.get("res/textures/environments/stormyday/irradiance-map/top.png").data(),
-        .back   = root.get("res/textures/environments/stormyday/irradiance-map/back.png").data(),
-        .front  = root.get("res/textures/environments/stormyday/irradiance-map/front.png").data() });
-    cubemapStore.insert("archipelago", {
-        .right  = root.get("res/textures/environments/archipelago/cubemap/right.png").data(),
-        .left   = root.get("res/textures/environments/archipelago/cubemap/left.png").data(),
-        .bottom = root.get("res/textures/environments/archipelago/cubemap/bottom.png").data(),
-        .top    = root.get("res/textures/environments/archipelago/cubemap/top.png").data(),
-        .back   = root.get("res/textures/environments/archipelago/cubemap/back.png").data(),
-        .front  = root.get("res/textures/environments/archipelago/cubemap/front.png").data() });
-    cubemapStore.insert("archipelago-irradiance-map", {
-        .right  = root.get("res/textures/environments/archipelago/irradiance-map/right.png").data(),
-        .left   = root.get("res/textures/environments/archipelago/irradiance-map/left.png").data(),
-        .bottom = root.get("res/textures/environments/archipelago/irradiance-map/bottom.png").data(),
-        .top    = root.get("res/textures/environments/archipelago/irradiance-map/top.png").data(),
-        .back   = root.get("res/textures/environments/archipelago/irradiance-map/back.png").data(),
-        .front  = root.get("res/textures/environments/archipelago/irradiance-map/front.png").data() });
-
-    programStore.insert("shadow_volume", {
-        .vertexShader   = root.get("res/shaders/shadow_volume.vert").data(),
-        .geometryShader = root.get("res/shaders/shadow_volume.geom").data(),
-        .fragmentShader = root.get("res/shaders/shadow_volume.frag").data() });
-    programStore.insert("shadow_imprint", {
-        .vertexShader   = root.get("res/shaders/shadow_imprint.vert").data(),
-        .fragmentShader = root.get("res/shaders/shadow_imprint.frag").data() });
-    programStore.insert("filling", {
-        .vertexShader   = root.get("res/shaders/filling.vert").data(),
-        .fragmentShader = root.get("res/shaders/filling.frag").data() });
-    programStore.insert("geometry_buffer", {
-        .vertexShader   = root.get("res/shaders/geometry_buffer.vert").data(),
-        .fragmentShader = root.get("res/shaders/geometry_buffer.frag").data() });
-    programStore.insert("deferred_shading", {
-        .vertexShader   = root.get("res/shaders/deferred_shading.vert").data(),
-        .fragmentShader = root.get("res/shaders/deferred_shading.frag").data() });
-
-    meshStore.insert("twisted_torus", {
-        .object          = root.get("res/objects/twisted-torus.obj").data(),
-        .diffuseTexture  = root.get("res/textures/surfaces/old_tiles/diffuse.png").data(),
-        .metallicTexture = root.get("res/textures/surfaces/old_tiles/metallicness.png").data(),
-        .roughTexture    = root.get("res/textures/surfaces/old_tiles/roughness.png").data(),
-        .normalTexture   = root.get("res/textures/surfaces/old_tiles/normal.png").data() });
-    meshStore.insert("plan", {
-        .object          = root.get("res/objects/plan.obj").data(),
-        .diffuseTexture  = root.get("res/textures/surfaces/worn_plaster/diffuse.png").data(),
-        .metallicTexture = root.get("res/textures/surfaces/worn_plaster/metallicness.png").data(),
-        .roughTexture    = root.get("res/textures/surfaces/worn_plaster/roughness.png").data(),
-        .normalTexture   = root.get("res/textures/surfaces/worn_plaster/normal.png").data() });
+    loadStart = chrono::steady_clock::now();
+    root = rootPath;
+
+    auto environment = [this](const string& path) {
+        return CubemapParams {
+            .right  = file((path + "/right.png").c_str()),
+            .left   = file((path + "/left.png").c_str()),
+            .bottom = file((path + "/bottom.png").c_str()),
+            .top    = file((path + "/top.png").c_str()),
+            .back   = file((path + "/back.png").c_str()),
+            .front  = file((path + "/front.png").c_str()) };
+    };
+
+    // CPU stage: reading and decoding files runs on the workers...
+    const char* cubemapKeys[4] {"stormyday", "stormyday-irradiance-map", "archipelago", "archipelago-irradiance-map"};
+    const CubemapParams cubemapParams[4] {
+        environment("res/textures/environments/stormyday/cubemap"),
+        environment("res/textures/environments/stormyday/irradiance-map"),
+        environment("res/textures/environments/archipelago/cubemap"),
+        environment("res/textures/environments/archipelago/irradiance-map") };
+    vector<MipChain> cubemapFaces[4];
+    ThreadPool& pool = threadPool();
+    ThreadPool::Group cubemaps;
+    for (unsigned int i = 0; i < 4; i ++) {
+        pool.enqueue([&cubemapFaces, &cubemapParams, i]() { cubemapFaces[i] = Cubemap::load(cubemapParams[i]); }, ThreadPool::NORMAL, &cubemaps);
+    }
+
+    // ...while this thread, owning the GL context, compiles the programs
+    insertProgram("shadow_volume", {
+        .vertexShader   = file("res/shaders/shadow_volume.vert"),
+        .geometryShader = file("res/shaders/shadow_volume.geom"),
+        .fragmentShader = file("res/shaders/shadow_volume.frag") });
+    insertProgram("shadow_extrusion", {
+        .vertexShader   = file("res/shaders/shadow_extrusion.vert"),
+        .geometryShader = "",
+        .fragmentShader = file("res/shaders/shadow_volume.frag") });
+    insertProgram("shadow_imprint", {
+        .vertexShader   = file("res/shaders/shadow_imprint.vert"),
+        .geometryShader = "",
+        .fragmentShader = file("res/shaders/shadow_imprint.frag") });
+    insertProgram("shadow_map", {
+        .vertexShader   = file("res/shaders/shadow_map.vert"),
+        .geometryShader = "",
+        .fragmentShader = file("res/shaders/filling.frag") });
+    insertProgram("shadow_map_imprint", {
+        .vertexShader   = file("res/shaders/deferred_shading.vert"),
+        .geometryShader = "",
+        .fragmentShader = file("res/shaders/shadow_map_imprint.frag") });
+    insertProgram("filling", {
+        .vertexShader   = file("res/shaders/filling.vert"),
+        .geometryShader = "",
+        .fragmentShader = file("res/shaders/filling.frag") });
+    insertProgram("geometry_buffer", {
+        .vertexShader   = file("res/shaders/geometry_buffer.vert"),
+        .geometryShader = "",
+        .fragmentShader = file("res/shaders/geometry_buffer.frag") });
+    insertProgram("deferred_shading", {
+        .vertexShader   = file("res/shaders/deferred_shading.vert"),
+        .geometryShader = "",
+        .fragmentShader = file("res/shaders/deferred_shading.frag") });
+
+    // GL stage: upload the finished results, in a fixed order so ids don't depend on timing
+    pool.wait(cubemaps);
+    for (unsigned int i = 0; i < 4; i ++) {
+        cubemapStore.insert(cubemapKeys[i], new Cubemap(cubemapFaces[i]));
+        cubemapsParams.push_back(make_pair(cubemapStore.getId(cubemapKeys[i]), cubemapParams[i]));
+    }
+
+    // Meshes stream in the background, the placeholder is drawn until they are loaded
+    meshStore.insert("placeholder", {
+        .object          = file("res/objects/cube.obj"),
+        .diffuseTexture  = file("res/textures/default.png"),
+        .metallicTexture = "",
+        .roughTexture    = "",
+        .normalTexture   = "" });
+    requestMesh("twisted_torus", {
+        .object          = file("res/objects/twisted-torus.obj"),
+        .diffuseTexture  = file("res/textures/surfaces/old_tiles/diffuse.png"),
+        .metallicTexture = file("res/textures/surfaces/old_tiles/metallicness.png"),
+        .roughTexture    = file("res/textures/surfaces/old_tiles/roughness.png"),
+        .normalTexture   = file("res/textures/surfaces/old_tiles/normal.png") });
+    requestMesh("plan", {
+        .object          = file("res/objects/plan.obj"),
+        .diffuseTexture  = file("res/textures/surfaces/worn_plaster/diffuse.png"),
+        .metallicTexture = file("res/textures/surfaces/worn_plaster/metallicness.png"),
+        .roughTexture    = file("res/textures/surfaces/worn_plaster/roughness.png"),
+        .normalTexture   = file("res/textures/surfaces/worn_plaster/normal.png") });
 
     renderer.setup({
-        .cubemapId                = cubemapStore.getId("stormyday"),
-        .shadowVolumeProgramId    = programStore.getId("shadow_volume"),
-        .shadowImprintProgramId   = programStore.getId("shadow_imprint"),
-        .fillingProgramId         = programStore.getId("filling"),
-        .geometryBufferProgramId  = programStore.getId("geometry_buffer"),
-        .deferredShadingProgramId = programStore.getId("deferred_shading")
+        .cubemapId                 = cubemapStore.getId("stormyday"),
+        .shadowVolumeProgramId     = programStore.getId("shadow_volume"),
+        .shadowExtrusionProgramId  = programStore.getId("shadow_extrusion"),
+        .shadowImprintProgramId    = programStore.getId("shadow_imprint"),
+        .shadowMapProgramId        = programStore.getId("shadow_map"),
+        .shadowMapImprintProgramId = programStore.getId("shadow_map_imprint"),
+        .fillingProgramId          = programStore.getId("filling"),
+        .geometryBufferProgramId   = programStore.getId("geometry_buffer"),
+        .deferredShadingProgramId  = programStore.getId("deferred_shading"),
+        .placeholderMeshId         = meshStore.getId("placeholder"),
+        .width                     = width,
+        .height                    = height
     });
+    renderer.load(pool);
+
+    watcher.reset(new FileWatcher(Path(root).get("res").data()));
+
+    info("Game: loaded in", chrono::duration<double, milli>(chrono::steady_clock::now() - loadStart).count(), "ms on", pool.size() + 1, "threads");
 
     setupWorld();
     addEntity();
@@ -107,12 +155,153 @@ void Game::update(float seconds)
 
 void Game::draw()
 {
+    applyRequests();
+    reload();
+
+    const bool streaming = meshStreamer.getPending() > 0;
+    for (unsigned int meshId : meshStreamer.collect()) {
+        renderer.reloadMesh(meshId);
+    }
+
+    const auto frameStart = chrono::steady_clock::now();
     renderSystem.update(renderer);
+    if (shadowBenchmark.running) updateShadowBenchmark(chrono::duration<double, milli>(chrono::steady_clock::now() - frameStart).count());
+
+    for (auto& wanted : renderer.getWantedMeshes()) {
+        meshStreamer.prioritize(wanted.first, wanted.second);
+    }
+
+    const double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - loadStart).count();
+    if (!drawn) {
+        drawn = true;
+        info("Game: first frame", elapsed, "ms after loading started");
+    }
+    if (streaming && meshStreamer.getPending() == 0) {
+        info("Game: every mesh streamed in", elapsed, "ms after loading started");
+    }
 }
 
 void Game::reload()
 {
-    // TODO... reload
+    if (!watcher) return;
+
+    // Only the assets made from a changed file are rebuilt, in their store slot
+    for (const string& changed : watcher->poll()) {
+        bool used = false;
+
+        for (auto& program : programsParams) {
+            const ProgramParams& params = program.second;
+            if (changed != params.vertexShader && changed != params.geometryShader && changed != params.fragmentShader) continue;
+            used = true;
+            // A shader being edited often doesn't build, keep drawing with the previous program
+            Program* reloaded = new Program(params);
+            if (!reloaded->isLinked()) {
+                error("Game: keeping the previous program, reloading failed after", changed, "changed");
+                delete reloaded;
+                continue;
+            }
+            programStore.replace(program.first, reloaded);
+        }
+
+        for (auto& cubemap : cubemapsParams) {
+            const CubemapParams& params = cubemap.second;
+            const char* faces[6] {params.right, params.left, params.bottom, params.top, params.back, params.front};
+            if (find(begin(faces), end(faces), changed) == end(faces)) continue;
+            cubemapStore.replace(cubemap.first, new Cubemap(Cubemap::load(params)));
+            used = true;
+        }
+
+        // A mesh is rebuilt off this thread and swapped once collected
+        for (auto& mesh : meshesParams) {
+            if (changed != mesh.second.object) continue;
+            meshStreamer.reload(mesh.first, mesh.second);
+            used = true;
+        }
+
+        if (renderer.reloadTexture(changed)) used = true;
+
+        if (used) info("Game: reloaded", changed);
+    }
+}
+
+const char* Game::file(const char* path)
+{
+    // Deque elements never move, the params pointing at them stay valid
+    files.push_back(Path(root).get(path).data());
+    return files.back().c_str();
+}
+
+void Game::toggleShadowVolumes()
+{
+    requests |= TOGGLE_SHADOW_VOLUMES;
+}
+
+void Game::toggleShadowTechnique()
+{
+    requests |= TOGGLE_SHADOW_TECHNIQUE;
+}
+
+void Game::benchmarkShadows()
+{
+    requests |= BENCHMARK_SHADOWS;
+}
+
+void Game::applyRequests()
+{
+    const unsigned int pending = requests.exchange(0);
+
+    // Between frames, so a frame builds and draws its volumes in the same mode
+    if (pending & TOGGLE_SHADOW_VOLUMES) {
+        renderer.setShadowVolumeMode(renderer.getShadowVolumeMode() == Renderer::CPU ? Renderer::GEOMETRY_SHADER : Renderer::CPU);
+    }
+
+    if (pending & TOGGLE_SHADOW_TECHNIQUE && !shadowBenchmark.running) {
+        renderer.setShadowTechnique(renderer.getShadowTechnique() == Renderer::SHADOW_MAPS ? Renderer::SHADOW_VOLUMES : Renderer::SHADOW_MAPS);
+    }
+    if (pending & BENCHMARK_SHADOWS && !shadowBenchmark.running) {
+        shadowBenchmark = ShadowBenchmark();
+        shadowBenchmark.running = true;
+        shadowBenchmark.restore = renderer.getShadowTechnique();
+        renderer.setShadowTechnique(Renderer::SHADOW_VOLUMES);
+        info("Game: benchmarking the shadow techniques");
+    }
+}
+
+void Game::updateShadowBenchmark(double frameMilliseconds)
+{
+    // Timers are read back a few frames late, the first frames of each technique are left out
+    const unsigned int warmup = 10;
+    const unsigned int frames = 300;
+
+    ShadowBenchmark& benchmark = shadowBenchmark;
+    const Renderer::ShadowTechnique technique = renderer.getShadowTechnique();
+    if (benchmark.frame >= warmup) {
+        benchmark.gpuMilliseconds[technique] += renderer.getStatistics().shadowMilliseconds / frames;
+        benchmark.cpuMilliseconds[technique] += frameMilliseconds / frames;
+    }
+    if (++ benchmark.frame < warmup + frames) return;
+
+    benchmark.frame = 0;
+    if (technique == Renderer::SHADOW_VOLUMES) {
+        renderer.setShadowTechnique(Renderer::SHADOW_MAPS);
+        return;
+    }
+
+    info("Game: shadow volumes", benchmark.gpuMilliseconds[Renderer::SHADOW_VOLUMES], "ms GPU,", benchmark.cpuMilliseconds[Renderer::SHADOW_VOLUMES], "ms CPU per frame");
+    info("Game: shadow maps   ", benchmark.gpuMilliseconds[Renderer::SHADOW_MAPS], "ms GPU,", benchmark.cpuMilliseconds[Renderer::SHADOW_MAPS], "ms CPU per frame");
+    benchmark.running = false;
+    renderer.setShadowTechnique(benchmark.restore);
+}
+
+void Game::insertProgram(const char* key, ProgramParams params)
+{
+    programStore.insert(key, params);
+    programsParams.push_back(make_pair(programStore.getId(key), params));
+}
+
+void Game::requestMesh(const char* key, MeshParams params)
+{
+    meshesParams.push_back(make_pair(meshStreamer.request(key, params), params));
 }
 
 void Game::setupWorld()
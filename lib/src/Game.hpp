@@ -11,15 +11,26 @@
 #include <components/Visibility.hpp>
 
 #include <graphic/Renderer.hpp>
+#include <graphic/MeshStreamer.hpp>
 
 #include <utils/Store.hpp>
+#include <utils/FileWatcher.hpp>
+
+#include <graphic/CubemapParams.hpp>
+#include <graphic/ProgramParams.hpp>
+#include <graphic/MeshParams.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 class Cubemap;
 class Program;
 class Mesh;
-struct CubemapParams;
-struct ProgramParams;
-struct MeshParams;
 
 class Game
 {
@@ -27,17 +38,53 @@ public:
 
     Game();
 
-    void load(const char* rootPath);
+    void load(const char* rootPath, int width, int height);
     void update(float seconds);
     void draw();
     void reload();
+    // Switch the shadow volumes between the geometry shader and the CPU
+    void toggleShadowVolumes();
+    // Switch the shadows between volumes and cascaded shadow maps
+    void toggleShadowTechnique();
+    // Draw the scene with each shadow technique in turn, then log what their passes cost
+    void benchmarkShadows();
+    // These are asked from the event thread, they are applied on the next draw,
+    // on the thread owning the GL context
 
 private:
 
     float previousUpdateSeconds = 0.f;
 
+    // Time to first frame
+    std::chrono::steady_clock::time_point loadStart;
+    bool drawn = false;
+
+    struct ShadowBenchmark
+    {
+        bool running = false;
+        unsigned int frame = 0;
+        Renderer::ShadowTechnique restore = Renderer::SHADOW_VOLUMES;
+        double gpuMilliseconds[2] {};
+        double cpuMilliseconds[2] {}; // Culling, sorting, uploads and draw calls
+    };
+    ShadowBenchmark shadowBenchmark;
+
+    enum Request
+    {
+        TOGGLE_SHADOW_VOLUMES   = 1 << 0,
+        TOGGLE_SHADOW_TECHNIQUE = 1 << 1,
+        BENCHMARK_SHADOWS       = 1 << 2
+    };
+    std::atomic<unsigned int> requests {0};
+    void applyRequests();
+
     void setupWorld();
     void addEntity();
+    void updateShadowBenchmark(double frameMilliseconds);
+
+    const char* file(const char* path);
+    void insertProgram(const char* key, ProgramParams params);
+    void requestMesh(const char* key, MeshParams params);
 
     ecs::EntityManager entities;
 
@@ -53,4 +100,14 @@ private:
     Store<const char*, Mesh, MeshParams> meshStore;
     Store<const char*, Program, ProgramParams> programStore;
     Store<const char*, Cubemap, CubemapParams> cubemapStore;
+
+    MeshStreamer meshStreamer;
+
+    // Files of every asset, and what each asset is made of to rebuild it when they change
+    std::string root;
+    std::deque<std::string> files;
+    std::vector<std::pair<unsigned int, ProgramParams>> programsParams;
+    std::vector<std::pair<unsigned int, CubemapParams>> cubemapsParams;
+    std::vector<std::pair<unsigned int, MeshParams>> meshesParams;
+    std::unique_ptr<FileWatcher> watcher;
 };
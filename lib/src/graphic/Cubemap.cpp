@@ -1,34 +1,47 @@
 #include "Cubemap.hpp"
-#include "../utils/PNG.hpp"
+#include "GLState.hpp"
 #include <string>
 
 using namespace std;
 
 Cubemap::Cubemap(CubemapParams params)
+    : Cubemap(load(params))
 {
-    const char* filenames[6] {params.right, params.left, params.bottom, params.top, params.back, params.front};
+}
 
+Cubemap::Cubemap(const vector<MipChain>& faces)
+{
     glGenTextures(1, &id);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, id);
-    for(GLuint i = 0; i < 6; i++) {
-        PNG png(filenames[i]);
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, GLint(png.width()), GLint(png.height()), 0, GL_RGBA, GL_UNSIGNED_BYTE, png.data());
+    glState().bindTexture(GL_TEXTURE0, GL_TEXTURE_CUBE_MAP, id);
+    for(GLuint i = 0; i < faces.size(); i++) {
+        const MipChain& chain = faces[i];
+        if (chain.levels.empty()) continue;
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, GLint(chain.width), GLint(chain.height), 0, GL_RGBA, GL_UNSIGNED_BYTE, chain.levels[0].data());
     }
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 }
 
 Cubemap::~Cubemap()
 {
-    glDeleteTextures(1, &id);
+    glState().deleteTexture(id);
+}
+
+vector<MipChain> Cubemap::load(CubemapParams params)
+{
+    const char* filenames[6] {params.right, params.left, params.bottom, params.top, params.back, params.front};
+
+    vector<MipChain> faces(6);
+    for(unsigned int i = 0; i < 6; i++) {
+        if (!loadCooked(filenames[i], faces[i], false)) faces[i] = MipChain();
+    }
+    return faces;
 }
 
 void Cubemap::bind(GLuint textureUnit)
 {
-    glActiveTexture(textureUnit);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, id);
+    glState().bindTexture(textureUnit, GL_TEXTURE_CUBE_MAP, id);
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include <graphic/CubemapParams.hpp>
+#include <utils/TextureCooker.hpp>
 #include <OpenGL.hpp>
 #include <vector>
 
@@ -9,8 +10,12 @@ class Cubemap
 public:
 
     Cubemap(CubemapParams params);
+    // Faces loaded beforehand, on a loading thread for instance
+    Cubemap(const std::vector<MipChain>& faces);
     ~Cubemap();
 
+    // Read the faces' pixels, nothing is done with GL
+    static std::vector<MipChain> load(CubemapParams params);
     void bind(GLuint textureUnit);
 
 private:
@@ -0,0 +1,131 @@
+#include "DrawList.hpp"
+#include <string.h>
+
+using namespace std;
+using namespace glm;
+
+namespace
+{
+    // Bits of each field of the key, from the most significant
+    const unsigned int passBits = 4;
+    const unsigned int programBits = 7;
+    const unsigned int materialBits = 16;
+    const unsigned int meshBits = 14;
+    const unsigned int lodBits = 2;
+    const unsigned int movingBits = 1;
+    const unsigned int depthBits = 20;
+
+    // Positive floats compare like their bit patterns: keeping the exponent
+    // and the high mantissa bits quantizes the depth with a relative precision
+    uint64_t quantize(float depth)
+    {
+        uint32_t bits;
+        depth = depth > 0.f ? depth : 0.f;
+        memcpy(&bits, &depth, sizeof(bits));
+        return bits >> (32 - depthBits);
+    }
+}
+
+uint64_t DrawList::key(unsigned int pass, unsigned int program, unsigned int material, unsigned int mesh, unsigned int lod, bool moving, float depth)
+{
+    uint64_t key = pass & ((1u << passBits) - 1);
+    key = (key << programBits) | (program & ((1u << programBits) - 1));
+    key = (key << materialBits) | (material & ((1u << materialBits) - 1));
+    key = (key << meshBits) | (mesh & ((1u << meshBits) - 1));
+    key = (key << lodBits) | (lod & ((1u << lodBits) - 1));
+    key = (key << movingBits) | (moving ? 1u : 0u);
+    key = (key << depthBits) | quantize(depth);
+    return key;
+}
+
+void DrawList::clear()
+{
+    meshes.clear();
+    lods.clear();
+    movings.clear();
+    transforms.clear();
+}
+
+void DrawList::add(unsigned int meshId, const vec3& position, const quat& orientation, const vec3& scale, bool moving)
+{
+    meshes.push_back(meshId);
+    lods.push_back(0);
+    movings.push_back(moving);
+    transforms.add(position, orientation, scale);
+}
+
+void DrawList::sort(const mat4& view, const vector<unsigned int>& materials)
+{
+    keys.resize(meshes.size());
+    order.resize(meshes.size());
+
+    // Every mesh is drawn by the same programs so far
+    const vec4 forward(-view[0][2], -view[1][2], -view[2][2], -view[3][2]);
+    for (unsigned int i = 0; i < meshes.size(); i ++) {
+        const float depth = dot(forward, vec4(transforms.getPosition(i), 1.f));
+        keys[i] = key(0, 0, materials[meshes[i]], meshes[i], lods[i], movings[i], depth);
+        order[i] = i;
+    }
+
+    radixSort.sort(keys, order);
+    sorted.gather(transforms, order);
+
+    batches.clear();
+    for (unsigned int i = 0; i < order.size(); i ++) {
+        const unsigned int meshId = meshes[order[i]];
+        const unsigned int lod = lods[order[i]];
+        const bool moving = movings[order[i]];
+        if (!batches.empty() && batches.back().meshId == meshId && batches.back().lod == lod && batches.back().moving == moving) {
+            batches.back().count ++;
+        } else {
+            batches.push_back({meshId, lod, moving, i, 1});
+        }
+    }
+}
+
+void DrawList::remap(const vector<unsigned int>& _meshes)
+{
+    for (auto& meshId : meshes) {
+        meshId = _meshes[meshId];
+    }
+}
+
+void DrawList::setLod(unsigned int instance, unsigned int lod)
+{
+    lods[instance] = lod;
+}
+
+unsigned int DrawList::size() const
+{
+    return unsigned(meshes.size());
+}
+
+const vector<unsigned int>& DrawList::getMeshes() const
+{
+    return meshes;
+}
+
+vec3 DrawList::getPosition(unsigned int instance) const
+{
+    return transforms.getPosition(instance);
+}
+
+vec3 DrawList::getScale(unsigned int instance) const
+{
+    return transforms.getScale(instance);
+}
+
+const vector<DrawList::Batch>& DrawList::getBatches() const
+{
+    return batches;
+}
+
+const vector<unsigned int>& DrawList::getOrder() const
+{
+    return order;
+}
+
+const Transforms& DrawList::getTransforms() const
+{
+    return sorted;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "../utils/RadixSort.hpp"
+#include "../utils/Transforms.hpp"
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <vector>
+
+// Instances to draw this frame. Sorting orders them by a 64 bits key
+// (pass, program, material, mesh, level of detail and motion, depth) and
+// merges the consecutive instances of a mesh's level into batches drawn with
+// one instanced command, still instances apart from the moving ones.
+class DrawList
+{
+
+public:
+
+    struct Batch
+    {
+        unsigned int meshId;
+        unsigned int lod;
+        bool moving;
+        unsigned int first;
+        unsigned int count;
+    };
+
+    void clear();
+    // Instances not moving are expected at the same place next frame
+    void add(unsigned int meshId, const glm::vec3& position, const glm::quat& orientation, const glm::vec3& scale, bool moving = true);
+
+    // Sort the instances, front to back within a batch, as seen from view.
+    // materials holds the material of each mesh, indexed by mesh id
+    void sort(const glm::mat4& view, const std::vector<unsigned int>& materials);
+
+    // Draw each instance of mesh m with meshes[m] instead, before sorting
+    void remap(const std::vector<unsigned int>& meshes);
+    // Draw an instance with a level of detail of its mesh, 0 being the finest
+    void setLod(unsigned int instance, unsigned int lod);
+
+    unsigned int size() const;
+    // Meshes and positions of the instances, in the order they were added
+    const std::vector<unsigned int>& getMeshes() const;
+    glm::vec3 getPosition(unsigned int instance) const;
+    glm::vec3 getScale(unsigned int instance) const;
+    const std::vector<Batch>& getBatches() const;
+    // Index each sorted instance was added at
+    const std::vector<unsigned int>& getOrder() const;
+    // Sorted instances' transforms, batches index them
+    const Transforms& getTransforms() const;
+
+    static uint64_t key(unsigned int pass, unsigned int program, unsigned int material, unsigned int mesh, unsigned int lod, bool moving, float depth);
+
+private:
+
+    std::vector<unsigned int> meshes;
+    std::vector<unsigned int> lods;
+    std::vector<bool> movings;
+    Transforms transforms;
+
+    std::vector<uint64_t> keys;
+    std::vector<unsigned int> order;
+    RadixSort radixSort;
+
+    Transforms sorted;
+    std::vector<Batch> batches;
+};
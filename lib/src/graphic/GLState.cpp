@@ -0,0 +1,168 @@
+#include "GLState.hpp"
+
+const unsigned int GLState::textureUnits;
+const unsigned int GLState::textureTargets;
+
+namespace
+{
+    // Index of the texture targets tracked per unit, textureTargets when not tracked
+    unsigned int targetIndex(GLenum target)
+    {
+        switch (target) {
+            case GL_TEXTURE_2D: return 0;
+            case GL_TEXTURE_CUBE_MAP: return 1;
+            case GL_TEXTURE_2D_ARRAY: return 2;
+            default: return 3;
+        }
+    }
+}
+
+GLState& glState()
+{
+    static GLState state;
+    return state;
+}
+
+template <typename T>
+bool GLState::change(Cached<T>& cached, const T& value)
+{
+    if (cached.known && cached.value == value) {
+        redundantCalls ++;
+        return false;
+    }
+    cached.known = true;
+    cached.value = value;
+    calls ++;
+    return true;
+}
+
+void GLState::useProgram(GLuint _program)
+{
+    if (change(program, _program)) glUseProgram(_program);
+}
+
+void GLState::bindVertexArray(GLuint _vertexArray)
+{
+    if (change(vertexArray, _vertexArray)) glBindVertexArray(_vertexArray);
+}
+
+void GLState::bindFramebuffer(GLuint _framebuffer)
+{
+    if (change(framebuffer, _framebuffer)) glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+}
+
+void GLState::bindTexture(GLenum unit, GLenum target, GLuint texture)
+{
+    const unsigned int u = unit - GL_TEXTURE0;
+    const unsigned int t = targetIndex(target);
+
+    if (u < textureUnits && t < textureTargets) {
+        if (textures[u][t].known && textures[u][t].value == texture) {
+            redundantCalls ++;
+            return;
+        }
+        textures[u][t].known = true;
+        textures[u][t].value = texture;
+    }
+
+    if (change(activeUnit, unit)) glActiveTexture(unit);
+    glBindTexture(target, texture);
+    calls ++;
+}
+
+void GLState::enable(GLenum capability)
+{
+    if (change(capabilities[capability], true)) glEnable(capability);
+}
+
+void GLState::disable(GLenum capability)
+{
+    if (change(capabilities[capability], false)) glDisable(capability);
+}
+
+void GLState::depthMask(GLboolean flag)
+{
+    if (change(depthMaskFlag, flag)) glDepthMask(flag);
+}
+
+void GLState::depthFunc(GLenum func)
+{
+    if (change(depthFuncMode, func)) glDepthFunc(func);
+}
+
+void GLState::colorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+{
+    const unsigned int bits = (red ? 1u : 0u) | (green ? 2u : 0u) | (blue ? 4u : 0u) | (alpha ? 8u : 0u);
+    if (change(colorMaskBits, bits)) glColorMask(red, green, blue, alpha);
+}
+
+void GLState::stencilFunc(GLenum func, GLint ref, GLuint mask)
+{
+    if (change(stencilFuncs, StencilFunc{func, ref, mask})) glStencilFunc(func, ref, mask);
+}
+
+void GLState::stencilOp(GLenum fail, GLenum depthFail, GLenum depthPass)
+{
+    const StencilOp op{fail, depthFail, depthPass};
+    if (stencilOps[0].known && stencilOps[1].known && stencilOps[0].value == op && stencilOps[1].value == op) {
+        redundantCalls ++;
+        return;
+    }
+    stencilOps[0].known = stencilOps[1].known = true;
+    stencilOps[0].value = stencilOps[1].value = op;
+    calls ++;
+    glStencilOp(fail, depthFail, depthPass);
+}
+
+void GLState::stencilOpSeparate(GLenum face, GLenum fail, GLenum depthFail, GLenum depthPass)
+{
+    if (face == GL_FRONT_AND_BACK) {
+        stencilOp(fail, depthFail, depthPass);
+        return;
+    }
+    if (change(stencilOps[face == GL_BACK ? 1 : 0], StencilOp{fail, depthFail, depthPass})) {
+        glStencilOpSeparate(face, fail, depthFail, depthPass);
+    }
+}
+
+void GLState::cullFace(GLenum mode)
+{
+    if (change(cullFaceMode, mode)) glCullFace(mode);
+}
+
+void GLState::frontFace(GLenum mode)
+{
+    if (change(frontFaceMode, mode)) glFrontFace(mode);
+}
+
+void GLState::scissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    if (change(scissorRect, Rect{x, y, width, height})) glScissor(x, y, width, height);
+}
+
+void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    if (change(viewportRect, Rect{x, y, width, height})) glViewport(x, y, width, height);
+}
+
+void GLState::deleteProgram(GLuint _program)
+{
+    if (program.value == _program) program.known = false;
+    glDeleteProgram(_program);
+}
+
+void GLState::deleteVertexArray(GLuint _vertexArray)
+{
+    if (vertexArray.value == _vertexArray) vertexArray.known = false;
+    glDeleteVertexArrays(1, &_vertexArray);
+}
+
+void GLState::deleteTexture(GLuint texture)
+{
+    for (auto& unit : textures) {
+        for (auto& target : unit) {
+            if (target.value == texture) target.known = false;
+        }
+    }
+    glDeleteTextures(1, &texture);
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <OpenGL.hpp>
+#include <unordered_map>
+
+// Cache in front of the GL state the renderer changes, calls that would not
+// change anything are dropped. Every GL state change of the renderer must go
+// through it for the cache to stay right.
+class GLState
+{
+
+public:
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray);
+    void bindFramebuffer(GLuint framebuffer);
+    void bindTexture(GLenum unit, GLenum target, GLuint texture);
+
+    void enable(GLenum capability);
+    void disable(GLenum capability);
+
+    void depthMask(GLboolean flag);
+    void depthFunc(GLenum func);
+    void colorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
+    void stencilFunc(GLenum func, GLint ref, GLuint mask);
+    void stencilOp(GLenum fail, GLenum depthFail, GLenum depthPass);
+    void stencilOpSeparate(GLenum face, GLenum fail, GLenum depthFail, GLenum depthPass);
+    void cullFace(GLenum mode);
+    void frontFace(GLenum mode);
+    void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    // Deleted names can be reused, they must not stay in the cache
+    void deleteProgram(GLuint program);
+    void deleteVertexArray(GLuint vertexArray);
+    void deleteTexture(GLuint texture);
+
+    // State changes issued and dropped since the last reset
+    unsigned int calls = 0;
+    unsigned int redundantCalls = 0;
+
+private:
+
+    template <typename T>
+    struct Cached
+    {
+        bool known = false;
+        T value {};
+    };
+
+    struct StencilOp
+    {
+        GLenum fail, depthFail, depthPass;
+        bool operator==(const StencilOp& o) const { return fail == o.fail && depthFail == o.depthFail && depthPass == o.depthPass; }
+    };
+
+    struct Rect
+    {
+        GLint x, y; GLsizei width, height;
+        bool operator==(const Rect& o) const { return x == o.x && y == o.y && width == o.width && height == o.height; }
+    };
+
+    struct StencilFunc
+    {
+        GLenum func; GLint ref; GLuint mask;
+        bool operator==(const StencilFunc& o) const { return func == o.func && ref == o.ref && mask == o.mask; }
+    };
+
+    template <typename T>
+    bool change(Cached<T>& cached, const T& value);
+
+    static const unsigned int textureUnits = 16;
+    static const unsigned int textureTargets = 3;
+
+    Cached<GLuint> program;
+    Cached<GLuint> vertexArray;
+    Cached<GLuint> framebuffer;
+    Cached<GLenum> activeUnit;
+    Cached<GLuint> textures[textureUnits][textureTargets];
+    std::unordered_map<GLenum, Cached<bool>> capabilities;
+    Cached<GLboolean> depthMaskFlag;
+    Cached<GLenum> depthFuncMode;
+    Cached<unsigned int> colorMaskBits;
+    Cached<StencilFunc> stencilFuncs;
+    Cached<StencilOp> stencilOps[2];
+    Cached<GLenum> cullFaceMode;
+    Cached<GLenum> frontFaceMode;
+    Cached<Rect> scissorRect;
+    Cached<Rect> viewportRect;
+};
+
+GLState& glState();
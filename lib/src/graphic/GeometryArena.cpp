@@ -0,0 +1,358 @@
+#include "GeometryArena.hpp"
+#include "Mesh.hpp"
+#include "GLState.hpp"
+#include "../utils/Log.hpp"
+#include "../utils/Transforms.hpp"
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+using namespace glm;
+
+#define POSITIONS 0
+#define ATTRIBUTES 1
+#define INDEXES 2
+
+namespace
+{
+    // Texture coordinates, normal, tangent and bitangent
+    const unsigned int attributeFloats = 11;
+
+    // Meshes are written one after the other, use immutable storage when available
+    void allocateStorage(GLenum target, GLsizeiptr size, const void* data)
+    {
+        if (GLAD_GL_ARB_buffer_storage) {
+            glBufferStorage(target, size, data, GL_DYNAMIC_STORAGE_BIT);
+        } else {
+            glBufferData(target, size, data, GL_STATIC_DRAW);
+        }
+    }
+
+    // Move the first used bytes of the buffer into a new one of size bytes
+    GLuint grow(GLuint buffer, GLsizeiptr used, GLsizeiptr size)
+    {
+        GLuint grown;
+        glGenBuffers(1, &grown);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+        allocateStorage(GL_COPY_WRITE_BUFFER, size, nullptr);
+        if (buffer && used > 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+        }
+        glDeleteBuffers(1, &buffer);
+        return grown;
+    }
+
+    void write(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+    }
+
+    template <typename T>
+    void writeIndexes(GLuint buffer, GLuint firstIndex, const vector<unsigned int>& indexes)
+    {
+        const vector<T> converted(indexes.begin(), indexes.end());
+        write(buffer, GLintptr(sizeof(T) * firstIndex), GLsizeiptr(sizeof(T) * converted.size()), converted.data());
+    }
+}
+
+GeometryArena::GeometryArena()
+    : multiDrawIndirect(GLAD_GL_ARB_multi_draw_indirect && GLAD_GL_ARB_base_instance)
+{
+    if (!multiDrawIndirect) {
+        warning("GeometryArena: multi draw indirect unavailable, falling back to one draw call per mesh");
+    }
+}
+
+GeometryArena::~GeometryArena()
+{
+    destroy();
+}
+
+bool GeometryArena::contains(unsigned int meshId) const
+{
+    return meshId < ranges.size() && ranges[meshId].loaded;
+}
+
+void GeometryArena::add(unsigned int meshId, const Mesh& mesh)
+{
+    remove(meshId);
+    if (ranges.size() <= meshId) ranges.resize(meshId + 1);
+
+    // Read straight from the mesh's mapped copy when it has one
+    const Span<vec4> vertexes = mesh.getVertexes();
+    const Span<vec2> uvs = mesh.getUvs();
+    const Span<vec3> normals = mesh.getNormals();
+    const Span<vec3> tangents = mesh.getTangents();
+    const Span<vec3> bitangents = mesh.getBitangents();
+
+    staged.push_back({meshId, {}, {}, {}});
+    Staged& copy = staged.back();
+
+    // Every level's triangles then adjacency follow the previous level in the mesh's index range
+    Range& range = ranges[meshId];
+    range.loaded = true;
+    range.vertexCount = GLuint(vertexes.size());
+    range.radius = mesh.getRadius();
+    range.lods.clear();
+    for (unsigned int lod = 0; lod < mesh.getLodCount() && lod < maxLods; lod ++) {
+        const Span<unsigned int> lodIndexes = mesh.getIndexes(lod);
+        const Span<unsigned int> lodAdjacencyIndexes = mesh.getAdjacencyIndexes(lod);
+        const GLuint first = GLuint(copy.indexes.size());
+        range.lods.push_back({
+            first, GLuint(lodIndexes.size()),
+            first + GLuint(lodIndexes.size()), GLuint(lodAdjacencyIndexes.size()),
+            mesh.getLodError(lod)
+        });
+        copy.indexes.insert(copy.indexes.end(), lodIndexes.begin(), lodIndexes.end());
+        copy.indexes.insert(copy.indexes.end(), lodAdjacencyIndexes.begin(), lodAdjacencyIndexes.end());
+    }
+    range.indexCount = GLuint(copy.indexes.size());
+    range.baseVertex = GLint(vertexSpace.allocate(range.vertexCount));
+    range.firstIndex = indexSpace.allocate(range.indexCount);
+
+    // Indexes are relative to each mesh's base vertex, 16 bits are enough until a mesh is larger
+    if (range.vertexCount > unsigned(numeric_limits<GLushort>::max()) + 1) wideIndexes = true;
+
+    copy.positions.assign(vertexes.begin(), vertexes.end());
+    copy.attributes.reserve(vertexes.size() * attributeFloats);
+    for (unsigned int i = 0; i < vertexes.size(); i ++) {
+        const vec2 uv = i < uvs.size() ? uvs[i] : vec2(0.f);
+        const vec3 normal = i < normals.size() ? normals[i] : vec3(0.f);
+        const vec3 tangent = i < tangents.size() ? tangents[i] : vec3(0.f);
+        const vec3 bitangent = i < bitangents.size() ? bitangents[i] : vec3(0.f);
+        copy.attributes.insert(copy.attributes.end(), {
+            uv.x, uv.y,
+            normal.x, normal.y, normal.z,
+            tangent.x, tangent.y, tangent.z,
+            bitangent.x, bitangent.y, bitangent.z
+        });
+    }
+}
+
+void GeometryArena::remove(unsigned int meshId)
+{
+    if (!contains(meshId)) return;
+
+    const Range& removed = ranges[meshId];
+    vertexSpace.release(GLuint(removed.baseVertex), removed.vertexCount);
+    indexSpace.release(removed.firstIndex, removed.indexCount);
+    ranges[meshId] = Range();
+
+    staged.erase(remove_if(staged.begin(), staged.end(), [meshId](const Staged& copy) { return copy.meshId == meshId; }), staged.end());
+}
+
+void GeometryArena::upload()
+{
+    if (staged.empty()) return;
+    if (!VAO) create();
+
+    const bool moved = vertexSpace.capacity > vertexCapacity || indexSpace.capacity > indexCapacity || (wideIndexes && indexType == GL_UNSIGNED_SHORT);
+    if (vertexSpace.capacity > vertexCapacity) {
+        buffers[POSITIONS] = grow(buffers[POSITIONS], GLsizeiptr(sizeof(vec4) * vertexCapacity), GLsizeiptr(sizeof(vec4) * vertexSpace.capacity));
+        buffers[ATTRIBUTES] = grow(buffers[ATTRIBUTES], GLsizeiptr(sizeof(GLfloat) * attributeFloats * vertexCapacity), GLsizeiptr(sizeof(GLfloat) * attributeFloats * vertexSpace.capacity));
+        vertexCapacity = vertexSpace.capacity;
+    }
+    if (wideIndexes && indexType == GL_UNSIGNED_SHORT) {
+        widenIndexes();
+    } else if (indexSpace.capacity > indexCapacity) {
+        const GLsizeiptr indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+        buffers[INDEXES] = grow(buffers[INDEXES], indexSize * indexCapacity, indexSize * indexSpace.capacity);
+        indexCapacity = indexSpace.capacity;
+    }
+    if (moved) pointVertexes();
+
+    for (auto& copy : staged) {
+        const Range& range = ranges[copy.meshId];
+        write(buffers[POSITIONS], GLintptr(sizeof(vec4) * GLuint(range.baseVertex)), GLsizeiptr(sizeof(vec4) * copy.positions.size()), copy.positions.data());
+        write(buffers[ATTRIBUTES], GLintptr(sizeof(GLfloat) * attributeFloats * GLuint(range.baseVertex)), GLsizeiptr(sizeof(GLfloat) * copy.attributes.size()), copy.attributes.data());
+        if (indexType == GL_UNSIGNED_SHORT) {
+            writeIndexes<GLushort>(buffers[INDEXES], range.firstIndex, copy.indexes);
+        } else {
+            writeIndexes<GLuint>(buffers[INDEXES], range.firstIndex, copy.indexes);
+        }
+    }
+
+    // The buffers hold the only copy
+    vector<Staged>().swap(staged);
+
+    info("GeometryArena:", vertexSpace.used, "of", vertexCapacity, "vertexes,", indexSpace.used, "of", indexCapacity, "indexes,", indexType == GL_UNSIGNED_SHORT ? "16" : "32", "bit");
+}
+
+unsigned int GeometryArena::getLodCount(unsigned int meshId) const
+{
+    return contains(meshId) ? unsigned(ranges[meshId].lods.size()) : 1;
+}
+
+float GeometryArena::getLodError(unsigned int meshId, unsigned int lod) const
+{
+    return contains(meshId) && lod < ranges[meshId].lods.size() ? ranges[meshId].lods[lod].error : 0.f;
+}
+
+float GeometryArena::getRadius(unsigned int meshId) const
+{
+    return contains(meshId) ? ranges[meshId].radius : 0.f;
+}
+
+DrawElementsIndirectCommand GeometryArena::getCommand(unsigned int meshId, unsigned int lod, unsigned int instances, unsigned int firstInstance) const
+{
+    const Range& range = ranges[meshId];
+    const Lod& level = range.lods[min(lod, unsigned(range.lods.size()) - 1)];
+    return {level.indexCount, instances, range.firstIndex + level.firstIndex, range.baseVertex, firstInstance};
+}
+
+DrawElementsIndirectCommand GeometryArena::getAdjacencyCommand(unsigned int meshId, unsigned int lod, unsigned int instances, unsigned int firstInstance) const
+{
+    const Range& range = ranges[meshId];
+    const Lod& level = range.lods[min(lod, unsigned(range.lods.size()) - 1)];
+    return {level.adjacencyIndexCount, instances, range.firstIndex + level.firstAdjacencyIndex, range.baseVertex, firstInstance};
+}
+
+void GeometryArena::bind(GLuint _instanceBuffer, GLintptr _instanceOffset, GLintptr _layerOffset)
+{
+    instanceBuffer = _instanceBuffer;
+    instanceOffset = _instanceOffset;
+    layerOffset = _layerOffset;
+
+    glState().bindVertexArray(VAO);
+    pointInstances(0);
+}
+
+void GeometryArena::draw(GLenum mode, const DrawElementsIndirectCommand* commands, GLintptr indirectOffset, unsigned int count)
+{
+    if (count == 0) return;
+
+    if (multiDrawIndirect) {
+        glMultiDrawElementsIndirect(mode, indexType, reinterpret_cast<const GLvoid *>(indirectOffset), GLsizei(count), 0);
+        return;
+    }
+
+    // Without base instance support the instance attributes are moved for every draw
+    const GLsizeiptr indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    for (unsigned int i = 0; i < count; i ++) {
+        const DrawElementsIndirectCommand& command = commands[i];
+        pointInstances(command.baseInstance);
+        glDrawElementsInstancedBaseVertex(mode, GLsizei(command.count), indexType, reinterpret_cast<const GLvoid *>(indexSize * command.firstIndex), GLsizei(command.instanceCount), command.baseVertex);
+    }
+}
+
+bool GeometryArena::isMultiDrawIndirect() const
+{
+    return multiDrawIndirect;
+}
+
+void GeometryArena::create()
+{
+    glGenVertexArrays(1, &VAO);
+    glState().bindVertexArray(VAO);
+
+    for (unsigned int i = 0; i < 5; i ++) {
+        glEnableVertexAttribArray(i);
+    }
+
+    // Model matrix rows and material layer
+    for (unsigned int i = 0; i < 4 ; i++) {
+        glVertexAttribDivisor(5 + i, 1);
+        glEnableVertexAttribArray(5 + i);
+    }
+}
+
+void GeometryArena::destroy()
+{
+    if (!VAO) return;
+    glState().deleteVertexArray(VAO);
+    glDeleteBuffers(3, buffers);
+    VAO = 0;
+}
+
+void GeometryArena::widenIndexes()
+{
+    // Once, when the first mesh of more than 65536 vertexes arrives
+    vector<GLushort> narrow(indexCapacity);
+    if (indexCapacity > 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffers[INDEXES]);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, GLsizeiptr(sizeof(GLushort) * narrow.size()), narrow.data());
+    }
+    vector<GLuint> wide(narrow.begin(), narrow.end());
+    wide.resize(indexSpace.capacity);
+
+    glDeleteBuffers(1, &buffers[INDEXES]);
+    glGenBuffers(1, &buffers[INDEXES]);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[INDEXES]);
+    allocateStorage(GL_COPY_WRITE_BUFFER, GLsizeiptr(sizeof(GLuint) * wide.size()), wide.data());
+
+    indexType = GL_UNSIGNED_INT;
+    indexCapacity = indexSpace.capacity;
+}
+
+void GeometryArena::pointVertexes()
+{
+    // The vertex array keeps pointing at the buffers it was given, point it at the grown ones
+    glState().bindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[POSITIONS]);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
+
+    const GLsizei stride = sizeof(GLfloat) * attributeFloats;
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[ATTRIBUTES]);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, 0);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid *>(sizeof(GLfloat) * 2));
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid *>(sizeof(GLfloat) * 5));
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid *>(sizeof(GLfloat) * 8));
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[INDEXES]);
+}
+
+void GeometryArena::pointInstances(GLuint firstInstance)
+{
+    const GLintptr offset = instanceOffset + GLintptr(sizeof(GLfloat) * Transforms::matrixFloats * firstInstance);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    for (unsigned int i = 0; i < 3 ; i++) {
+        glVertexAttribPointer(5 + i, 4, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * Transforms::matrixFloats, reinterpret_cast<const GLvoid *>(offset + GLintptr(sizeof(GLfloat) * i * 4)));
+    }
+    glVertexAttribPointer(8, 1, GL_FLOAT, GL_FALSE, sizeof(GLfloat), reinterpret_cast<const GLvoid *>(layerOffset + GLintptr(sizeof(GLfloat) * firstInstance)));
+}
+
+GLuint GeometryArena::Space::allocate(GLuint count)
+{
+    for (auto block = free.begin(); block != free.end(); block ++) {
+        if (block->second < count) continue;
+        const GLuint offset = block->first;
+        block->first += count;
+        block->second -= count;
+        if (block->second == 0) free.erase(block);
+        return offset;
+    }
+
+    while (used + count > capacity) {
+        capacity = std::max(capacity * 2, used + count);
+    }
+    used += count;
+    return used - count;
+}
+
+void GeometryArena::Space::release(GLuint offset, GLuint count)
+{
+    if (count == 0) return;
+
+    // Merge with the neighbouring free blocks
+    auto next = lower_bound(free.begin(), free.end(), make_pair(offset, count));
+    if (next != free.end() && offset + count == next->first) {
+        count += next->second;
+        next = free.erase(next);
+    }
+    if (next != free.begin() && prev(next)->first + prev(next)->second == offset) {
+        next = prev(next);
+        offset = next->first;
+        count += next->second;
+        next = free.erase(next);
+    }
+
+    // The end is given back to the unused space
+    if (offset + count == used) {
+        used = offset;
+    } else {
+        free.insert(next, make_pair(offset, count));
+    }
+}
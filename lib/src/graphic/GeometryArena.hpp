@@ -0,0 +1,119 @@
+#pragma once
+#include <OpenGL.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+
+class Mesh;
+
+// Layout expected by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// Every mesh's vertexes and indexes packed in shared buffers behind a single
+// vertex array, so a whole pass can be submitted with one multi draw call.
+// Meshes are written in place in the buffers, which double when full, and
+// their space is reused once removed. No copy is kept on the CPU.
+class GeometryArena
+{
+
+public:
+
+    GeometryArena();
+    ~GeometryArena();
+
+    bool contains(unsigned int meshId) const;
+    // Copy the mesh's geometry until the next upload writes it in the buffers
+    void add(unsigned int meshId, const Mesh& mesh);
+    // Free the mesh's space, to add it again once changed
+    void remove(unsigned int meshId);
+    void upload();
+
+    // Levels of detail of a mesh, their errors relative to its radius
+    unsigned int getLodCount(unsigned int meshId) const;
+    float getLodError(unsigned int meshId, unsigned int lod) const;
+    float getRadius(unsigned int meshId) const;
+
+    // Commands of a level of detail, the coarsest one when lod is past it
+    DrawElementsIndirectCommand getCommand(unsigned int meshId, unsigned int lod, unsigned int instances, unsigned int firstInstance) const;
+    DrawElementsIndirectCommand getAdjacencyCommand(unsigned int meshId, unsigned int lod, unsigned int instances, unsigned int firstInstance) const;
+
+    static const unsigned int maxLods = 4;
+
+    // Instances read their matrix at instanceOffset and their material layer at layerOffset
+    void bind(GLuint instanceBuffer, GLintptr instanceOffset, GLintptr layerOffset);
+    // Submit count commands, stored both in commands and at indirectOffset of the bound indirect buffer
+    void draw(GLenum mode, const DrawElementsIndirectCommand* commands, GLintptr indirectOffset, unsigned int count);
+
+    bool isMultiDrawIndirect() const;
+
+private:
+
+    // Relative to the mesh's first index, adjacency indexes follow the triangles'
+    struct Lod
+    {
+        GLuint firstIndex;
+        GLuint indexCount;
+        GLuint firstAdjacencyIndex;
+        GLuint adjacencyIndexCount;
+        float error;
+    };
+
+    struct Range
+    {
+        bool loaded = false;
+        GLint baseVertex = 0;
+        GLuint vertexCount = 0;
+        GLuint firstIndex = 0;
+        GLuint indexCount = 0;
+        float radius = 0.f;
+        std::vector<Lod> lods;
+    };
+
+    // Geometry added since the last upload
+    struct Staged
+    {
+        unsigned int meshId;
+        std::vector<glm::vec4> positions;
+        std::vector<GLfloat> attributes;
+        std::vector<unsigned int> indexes;
+    };
+
+    // First fit allocation of a buffer's elements, the capacity doubles when full
+    struct Space
+    {
+        GLuint capacity = 0;
+        GLuint used = 0;
+        std::vector<std::pair<GLuint, GLuint>> free; // Offset and count, in order
+
+        GLuint allocate(GLuint count);
+        void release(GLuint offset, GLuint count);
+    };
+
+    void create();
+    void destroy();
+    void widenIndexes();
+    void pointVertexes();
+    void pointInstances(GLuint firstInstance);
+
+    std::vector<Range> ranges;
+    std::vector<Staged> staged;
+    Space vertexSpace;
+    Space indexSpace;
+    GLuint vertexCapacity = 0; // Allocated in the buffers
+    GLuint indexCapacity = 0;
+    bool wideIndexes = false;
+
+    bool multiDrawIndirect;
+    GLenum indexType = GL_UNSIGNED_SHORT;
+    GLuint VAO = 0;
+    GLuint buffers[3] {};
+    GLuint instanceBuffer = 0;
+    GLintptr instanceOffset = 0;
+    GLintptr layerOffset = 0;
+};
@@ -0,0 +1,43 @@
+#include "GpuTimer.hpp"
+
+const unsigned int GpuTimer::queryCount;
+
+GpuTimer::GpuTimer()
+{
+    glGenQueries(queryCount, queries);
+}
+
+GpuTimer::~GpuTimer()
+{
+    glDeleteQueries(queryCount, queries);
+}
+
+void GpuTimer::begin()
+{
+    GLint available = 0;
+    if (begun >= queryCount) glGetQueryObjectiv(queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available) {
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(queries[query], GL_QUERY_RESULT, &elapsed);
+        milliseconds = float(elapsed) * 1e-6f;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, queries[query]);
+    begun ++;
+}
+
+void GpuTimer::end()
+{
+    glEndQuery(GL_TIME_ELAPSED);
+    query = (query + 1) % queryCount;
+}
+
+void GpuTimer::reset()
+{
+    begun = 0;
+    milliseconds = 0.f;
+}
+
+float GpuTimer::getMilliseconds() const
+{
+    return milliseconds;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <OpenGL.hpp>
+
+// GPU time spent between begin and end. Queries go round a ring and are read
+// back a few frames late, once available, so timing never waits on the GPU.
+class GpuTimer
+{
+
+public:
+
+    GpuTimer();
+    ~GpuTimer();
+
+    void begin();
+    void end();
+    // Drop the queries in flight, what they time has changed
+    void reset();
+
+    // Time of the latest query read back
+    float getMilliseconds() const;
+
+private:
+
+    static const unsigned int queryCount = 3;
+    GLuint queries[queryCount] {};
+    unsigned int query = 0;
+    unsigned int begun = 0;
+    float milliseconds = 0.f;
+};
@@ -0,0 +1,201 @@
+#include "MaterialArrays.hpp"
+#include "Mesh.hpp"
+#include "../utils/Log.hpp"
+#include "../utils/ThreadPool.hpp"
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+    // Bits of the layer in a material's sort key
+    const unsigned int layerBits = 10;
+
+    bool load(const string& file, MipChain& chain, bool color)
+    {
+        if (file.empty() || !loadCooked(file.c_str(), chain, true, color)) {
+            chain = MipChain();
+            return false;
+        }
+        return true;
+    }
+}
+
+bool MaterialArrays::isColor(unsigned int channel)
+{
+    return channel == 0;
+}
+
+bool MaterialArrays::contains(unsigned int meshId) const
+{
+    return meshId < meshesMaterials.size() && meshesMaterials[meshId] != -1;
+}
+
+void MaterialArrays::add(unsigned int meshId, Mesh& mesh)
+{
+    if (meshesMaterials.size() <= meshId) meshesMaterials.resize(meshId + 1, -1);
+
+    // Meshes using the same textures share their material
+    const vector<string>& files = mesh.getTextures();
+    for (unsigned int m = 0; m < materials.size(); m ++) {
+        if (materials[m].files == files) {
+            meshesMaterials[meshId] = int(m);
+            return;
+        }
+    }
+
+    Material material;
+    material.files = files;
+    material.chains.swap(mesh.getLoadedTextures());
+    material.chains.resize(channels);
+
+    meshesMaterials[meshId] = int(materials.size());
+    materials.push_back(material);
+}
+
+void MaterialArrays::upload(ThreadPool* pool)
+{
+    vector<unsigned int> added;
+    for (unsigned int m = 0; m < materials.size(); m ++) {
+        if (!materials[m].placed) added.push_back(m);
+    }
+
+    // Every texture of the new materials not loaded yet is loaded by its own task
+    ThreadPool::Group group;
+    for (unsigned int m : added) {
+        for (unsigned int c = 0; c < channels; c ++) {
+            const string& file = materials[m].files[c];
+            MipChain& chain = materials[m].chains[c];
+            const bool color = isColor(c);
+            if (!chain.levels.empty()) continue;
+            if (pool) {
+                pool->enqueue([&file, &chain, color]() { load(file, chain, color); }, ThreadPool::NORMAL, &group);
+            } else {
+                load(file, chain, color);
+            }
+        }
+    }
+    if (pool) pool->wait(group);
+
+    for (unsigned int m : added) {
+        place(m);
+    }
+
+    for (auto& set : sets) {
+        if (set->dirty) upload(*set);
+    }
+}
+
+bool MaterialArrays::reload(const string& file)
+{
+    bool found = false;
+    for (auto& material : materials) {
+        if (!material.placed || find(material.files.begin(), material.files.end(), file) == material.files.end()) continue;
+        material.uploaded = false;
+        sets[material.set]->dirty = true;
+        found = true;
+    }
+    return found;
+}
+
+unsigned int MaterialArrays::getMaterial(unsigned int meshId) const
+{
+    const Material& material = materials[unsigned(meshesMaterials[meshId])];
+    return (material.set << layerBits) | material.layer;
+}
+
+unsigned int MaterialArrays::getSet(unsigned int meshId) const
+{
+    return materials[unsigned(meshesMaterials[meshId])].set;
+}
+
+GLfloat MaterialArrays::getLayer(unsigned int meshId) const
+{
+    return GLfloat(materials[unsigned(meshesMaterials[meshId])].layer);
+}
+
+void MaterialArrays::bind(unsigned int set, GLenum firstUnit)
+{
+    for (unsigned int c = 0; c < channels; c ++) {
+        sets[set]->arrays[c].bind(firstUnit + c);
+    }
+}
+
+void MaterialArrays::place(unsigned int m)
+{
+    Material& material = materials[m];
+
+    // The first texture gives the size of the material's layer
+    unsigned int width = 0;
+    unsigned int height = 0;
+    for (unsigned int c = 0; c < channels; c ++) {
+        MipChain& chain = material.chains[c];
+        if (chain.levels.empty()) continue;
+        if (width == 0) {
+            width = chain.width;
+            height = chain.height;
+        } else if (chain.width != width || chain.height != height) {
+            warning("MaterialArrays:", material.files[c], "is", chain.width, "x", chain.height, "instead of", width, "x", height, ", ignored");
+            chain = MipChain();
+        }
+    }
+
+    material.set = findSet(width ? width : 1, height ? height : 1);
+    Set& set = *sets[material.set];
+    material.layer = unsigned(set.materials.size());
+    material.placed = true;
+
+    set.materials.push_back(m);
+    set.dirty = true;
+}
+
+unsigned int MaterialArrays::findSet(unsigned int width, unsigned int height)
+{
+    for (unsigned int s = 0; s < sets.size(); s ++) {
+        if (sets[s]->width == width && sets[s]->height == height) return s;
+    }
+    sets.emplace_back(new Set());
+    sets.back()->width = width;
+    sets.back()->height = height;
+    return unsigned(sets.size() - 1);
+}
+
+void MaterialArrays::upload(Set& set)
+{
+    set.dirty = false;
+
+    // The arrays grow by doubling, growing loses their layers which are loaded again
+    const GLsizei needed = GLsizei(set.materials.size());
+    if (set.arrays[0].getLayers() < needed) {
+        GLsizei layers = set.arrays[0].getLayers() ? set.arrays[0].getLayers() : 1;
+        while (layers < needed) layers *= 2;
+        for (unsigned int c = 0; c < channels; c ++) {
+            set.arrays[c].allocate(GLsizei(set.width), GLsizei(set.height), layers, isColor(c));
+        }
+        for (unsigned int m : set.materials) {
+            materials[m].uploaded = false;
+        }
+    }
+
+    for (unsigned int m : set.materials) {
+        Material& material = materials[m];
+        if (material.uploaded) continue;
+
+        for (unsigned int c = 0; c < channels; c ++) {
+            MipChain& chain = material.chains[c];
+            if (chain.levels.empty() && load(material.files[c], chain, isColor(c)) && (chain.width != set.width || chain.height != set.height)) {
+                chain = MipChain();
+            }
+            if (chain.levels.empty()) {
+                set.arrays[c].clear(GLint(material.layer));
+            } else {
+                set.arrays[c].load(GLint(material.layer), chain);
+            }
+            // Layers are loaded again if the arrays ever grow
+            chain = MipChain();
+        }
+        material.uploaded = true;
+    }
+
+    info("MaterialArrays:", set.materials.size(), "materials of", set.width, "x", set.height, "in", set.arrays[0].getLayers(), "layers");
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "../utils/TextureArray.hpp"
+#include "../utils/TextureCooker.hpp"
+#include <OpenGL.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Mesh;
+class ThreadPool;
+
+// Meshes' textures packed in one texture array per channel (diffuse, metallic,
+// rough, normal). Materials of the same size share a set of arrays, each owns
+// a layer of them, so every mesh of a set is drawn with the same binds.
+class MaterialArrays
+{
+
+public:
+
+    static const unsigned int channels = 4;
+
+    // Only the diffuse channel holds sRGB colors, the others hold data
+    static bool isColor(unsigned int channel);
+
+    bool contains(unsigned int meshId) const;
+    // The mesh's textures are uploaded on the next upload, those the mesh
+    // loaded ahead are taken from it, the others are loaded then
+    void add(unsigned int meshId, Mesh& mesh);
+    // Load the added textures, spread over the pool's workers if there is one
+    void upload(ThreadPool* pool = nullptr);
+    // Upload the layers made from file again on the next upload, return whether there is any
+    bool reload(const std::string& file);
+
+    // Sort key of the mesh's material, valid once uploaded. The materials of a set are consecutive
+    unsigned int getMaterial(unsigned int meshId) const;
+    unsigned int getSet(unsigned int meshId) const;
+    GLfloat getLayer(unsigned int meshId) const;
+
+    // Bind the set's arrays to the units following firstUnit, one per channel
+    void bind(unsigned int set, GLenum firstUnit);
+
+private:
+
+    struct Material
+    {
+        std::vector<std::string> files;
+        std::vector<MipChain> chains;
+        unsigned int set = 0;
+        unsigned int layer = 0;
+        bool placed = false;
+        bool uploaded = false;
+    };
+
+    struct Set
+    {
+        unsigned int width = 0;
+        unsigned int height = 0;
+        std::vector<unsigned int> materials;
+        TextureArray arrays[channels];
+        bool dirty = false;
+    };
+
+    void place(unsigned int material);
+    unsigned int findSet(unsigned int width, unsigned int height);
+    void upload(Set& set);
+
+    std::vector<Material> materials;
+    std::vector<std::unique_ptr<Set>> sets;
+    std::vector<int> meshesMaterials;
+};
@@ -1,46 +1,147 @@
 #include "Mesh.hpp"
 #include "../../inc/utils/Utility.hpp"
-#include "../utils/Texture.hpp"
 #include "../utils/OBJ.hpp"
 #include "../utils/Log.hpp"
 #include "../utils/Manifold.hpp"
+#include "../utils/MeshOptimizer.hpp"
+#include "../utils/MeshSimplifier.hpp"
 #include "Material.hpp"
-#include "MeshVertexArray.hpp"
+#include "MaterialArrays.hpp"
+#include <algorithm>
 
 using namespace std;
 using namespace glm;
 
+namespace
+{
+    string file(const char* filename)
+    {
+        return isEmpty(filename) ? string() : string(filename);
+    }
+}
+
 Mesh::Mesh(MeshParams params)
-    : vertexArray(new MeshVertexArray())
-    , diffuseTexture(new Texture())
-    , metallicTexture(new Texture())
-    , roughTexture(new Texture())
-    , normalTexture(new Texture())
+    : textures({
+        file(params.diffuseTexture),
+        file(params.metallicTexture),
+        file(params.roughTexture),
+        file(params.normalTexture)
+    })
 {
-    OBJ(triangles, vertexes, uvs, normals, indexes).load(params.object);
+    uint64_t source = 0;
+    if (!loadCookedMesh(params.object, mapping, streams, source)) {
+        mapping.close();
+
+        parse(params.object);
+        streams.vertexes = vertexes;
+        streams.uvs = uvs;
+        streams.normals = normals;
+        streams.tangents = trianglesTangents;
+        streams.bitangents = trianglesBitangents;
+        streams.lods.assign(1, MeshLod());
+        streams.lods[0].indexes = indexes;
+        streams.lods[0].adjacencyIndexes = adjacencyIndexes;
+        for (auto& lod : lods) {
+            MeshLod level;
+            level.indexes = lod.indexes;
+            level.adjacencyIndexes = lod.adjacencyIndexes;
+            level.error = lod.error;
+            streams.lods.push_back(level);
+        }
+
+        if (source) {
+            writeCookedMesh(params.object, source, streams);
+            success("Mesh: cooked", params.object);
+        }
+    }
+
+    // Instances scale and turn around the origin, the bounds are centered on it
+    for (auto& vertex : streams.vertexes) {
+        radius = std::max(radius, length(vec3(vertex)));
+    }
+}
+
+Mesh::~Mesh()
+{
+}
+
+void Mesh::parse(const char* object)
+{
+    vector<unsigned int> positions;
+    OBJ(triangles, vertexes, uvs, normals, indexes, positions).load(object);
 
     verifyUVs();
+    normals.resize(vertexes.size(), vec3(0.f));
+    optimize(positions);
 
     initializeTriangleData(); // TODO Move to manifold
-    computeTrianglesPlaneEquations(); // TODO Move to manifold
     computeTrianglesTangents(); // TODO Move to manifold
-    generateTrianglesAdjacencyIndex(triangles, adjacencyIndexes);
+    generateAdjacencyIndexes(indexes, positions, adjacencyIndexes);
+    generateLods(positions);
+}
 
-    vertexArray->initialize(vertexes, uvs, normals, trianglesTangents, trianglesBitangents);
+void Mesh::optimize(vector<unsigned int>& positions)
+{
+    const VertexCacheStatistics before = analyzeVertexCache(indexes, vertexes.size());
+
+    optimizeVertexCache(indexes, vertexes.size());
+    optimizeOverdraw(indexes, vertexes);
+    const vector<unsigned int> remap = optimizeVertexFetch(indexes, vertexes.size());
+    remapVertexes(vertexes, remap);
+    remapVertexes(uvs, remap);
+    remapVertexes(normals, remap);
+    remapVertexes(positions, remap);
+
+    triangles.clear();
+    for (unsigned int i = 0; i + 2 < indexes.size(); i += 3) {
+        triangles.push_back(uvec3(indexes[i], indexes[i + 1], indexes[i + 2]));
+    }
 
-    if (!isEmpty(params.diffuseTexture)) diffuseTexture->load(params.diffuseTexture);
-    if (!isEmpty(params.metallicTexture)) metallicTexture->load(params.metallicTexture);
-    if (!isEmpty(params.roughTexture)) roughTexture->load(params.roughTexture);
-    if (!isEmpty(params.normalTexture)) normalTexture->load(params.normalTexture);
+    const VertexCacheStatistics after = analyzeVertexCache(indexes, vertexes.size());
+    info("Mesh: ACMR", before.acmr, "->", after.acmr, "ATVR", before.atvr, "->", after.atvr);
 }
 
-Mesh::~Mesh()
+void Mesh::generateLods(const vector<unsigned int>& positions)
+{
+    // Halve the triangles for each level, simplifying the full mesh every
+    // time so errors stay measured against it, until it stops paying off
+    const size_t maxLods = 4;
+    const size_t minTriangles = 32;
+
+    size_t previous = indexes.size();
+    while (lods.size() + 1 < maxLods && previous / 2 >= minTriangles * 3) {
+        Lod lod;
+        lod.indexes = simplifyMesh(indexes, vertexes, normals, uvs, positions, previous / 2, lod.error);
+        if (lod.indexes.size() > previous * 9 / 10) break;
+
+        optimizeVertexCache(lod.indexes, vertexes.size());
+        generateAdjacencyIndexes(lod.indexes, positions, lod.adjacencyIndexes);
+        previous = lod.indexes.size();
+        lods.push_back(lod);
+        info("Mesh: lod", lods.size(), "has", lod.indexes.size() / 3, "triangles, error", lod.error);
+    }
+}
+
+void Mesh::generateAdjacencyIndexes(const vector<unsigned int>& lodIndexes, const vector<unsigned int>& positions, vector<unsigned int>& lodAdjacencyIndexes)
 {
-    delete diffuseTexture;
-    delete metallicTexture;
-    delete roughTexture;
-    delete normalTexture;
-    delete vertexArray;
+    // Vertexes split on uv seams and hard edges still share their position,
+    // edges are matched on positions so silhouettes don't break there
+    vector<unsigned int> positionVertexes;
+    vector<uvec3> positionTriangles;
+    positionTriangles.reserve(lodIndexes.size() / 3);
+    for (unsigned int i = 0; i < positions.size(); i ++) {
+        if (positionVertexes.size() <= positions[i]) positionVertexes.resize(positions[i] + 1, ~0u);
+        if (positionVertexes[positions[i]] == ~0u) positionVertexes[positions[i]] = i;
+    }
+    for (size_t i = 0; i + 2 < lodIndexes.size(); i += 3) {
+        positionTriangles.push_back(uvec3(positions[lodIndexes[i]], positions[lodIndexes[i + 1]], positions[lodIndexes[i + 2]]));
+    }
+
+    lodAdjacencyIndexes.clear();
+    generateTrianglesAdjacencyIndex(positionTriangles, lodAdjacencyIndexes);
+    for (auto& index : lodAdjacencyIndexes) {
+        index = positionVertexes[index];
+    }
 }
 
 void Mesh::debug()
@@ -48,33 +149,74 @@ void Mesh::debug()
     OBJ::debug(triangles, vertexes, uvs, normals, indexes);
 }
 
-void Mesh::bindTexture(GLuint diffuse, GLuint metallic, GLuint rough, GLuint normal)
+const vector<string>& Mesh::getTextures() const
+{
+    return textures;
+}
+
+void Mesh::loadTextures()
+{
+    loadedTextures.resize(textures.size());
+    for (unsigned int i = 0; i < textures.size(); i ++) {
+        if (textures[i].empty() || !loadCooked(textures[i].c_str(), loadedTextures[i], true, MaterialArrays::isColor(i))) {
+            loadedTextures[i] = MipChain();
+        }
+    }
+}
+
+vector<MipChain>& Mesh::getLoadedTextures()
+{
+    return loadedTextures;
+}
+
+unsigned int Mesh::getLodCount() const
 {
-    diffuseTexture->bind(diffuse);
-    metallicTexture->bind(metallic);
-    roughTexture->bind(rough);
-    normalTexture->bind(normal);
+    return unsigned(streams.lods.size());
 }
 
-void Mesh::updateMatrices(unsigned int instances, const mat4* matrices)
+float Mesh::getLodError(unsigned int lod) const
 {
-    vertexArray->uploadMatrices(instances, matrices);
+    return streams.lods[lod].error;
 }
 
-void Mesh::draw(unsigned int instances)
+float Mesh::getRadius() const
 {
-    vertexArray->uploadIndexes(indexes);
-    vertexArray->bind();
-    glDrawElementsInstanced(GL_TRIANGLES, GLsizei(indexes.size()), GL_UNSIGNED_INT, 0, instances);
-    vertexArray->idle();
+    return radius;
 }
 
-void Mesh::drawAdjacency(unsigned int instances)
+Span<unsigned int> Mesh::getIndexes(unsigned int lod) const
 {
-    vertexArray->uploadIndexes(adjacencyIndexes);
-    vertexArray->bind();
-    glDrawElementsInstanced(GL_TRIANGLES_ADJACENCY, GLsizei(adjacencyIndexes.size()), GL_UNSIGNED_INT, 0, instances);
-    vertexArray->idle();
+    return streams.lods[lod].indexes;
+}
+
+Span<unsigned int> Mesh::getAdjacencyIndexes(unsigned int lod) const
+{
+    return streams.lods[lod].adjacencyIndexes;
+}
+
+Span<vec4> Mesh::getVertexes() const
+{
+    return streams.vertexes;
+}
+
+Span<vec2> Mesh::getUvs() const
+{
+    return streams.uvs;
+}
+
+Span<vec3> Mesh::getNormals() const
+{
+    return streams.normals;
+}
+
+Span<vec3> Mesh::getTangents() const
+{
+    return streams.tangents;
+}
+
+Span<vec3> Mesh::getBitangents() const
+{
+    return streams.bitangents;
 }
 
 void Mesh::verifyUVs()
@@ -88,7 +230,6 @@ void Mesh::initializeTriangleData()
 {
     trianglesTangents.resize(vertexes.size(), fvec3(0.f, 0.f, 0.f));
     trianglesBitangents.resize(vertexes.size(), fvec3(0.f, 0.f, 0.f));
-    trianglesPlaneEquations.reserve(triangles.size());
 }
 
 void Mesh::computeTrianglesTangents()
@@ -136,30 +277,3 @@ void Mesh::computeTrianglesTangents()
         trianglesBitangents[i1] = trianglesBitangents[i2] = trianglesBitangents[i3] = bitangent;
     }
 }
-
-void Mesh::computeTrianglesPlaneEquations()
-{
-    for (auto &triangle : triangles) {
-        const vec4& v1 = vertexes[triangle[0]];
-        const vec4& v2 = vertexes[triangle[1]];
-        const vec4& v3 = vertexes[triangle[2]];
-
-        trianglesPlaneEquations.push_back(fvec4(
-              v1.y * (v2.z - v3.z)
-            + v2.y * (v3.z - v1.z)
-            + v3.y * (v1.z - v2.z),
-
-              v1.z * (v2.x - v3.x)
-            + v2.z * (v3.x - v1.x)
-            + v3.z * (v1.x - v2.x),
-
-              v1.x * (v2.y - v3.y)
-            + v2.x * (v3.y - v1.y)
-            + v3.x * (v1.y - v2.y),
-
-            -(v1.x * (v2.y * v3.z - v3.y * v2.z)
-            + v2.x * (v3.y * v1.z - v1.y * v3.z)
-            + v3.x * (v1.y * v2.z - v2.y * v1.z))
-        ));
-    }
-}
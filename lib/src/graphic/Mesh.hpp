@@ -1,47 +1,78 @@
 #pragma once
 #include <graphic/MeshParams.hpp>
+#include <utils/TextureCooker.hpp>
+#include <utils/MeshCooker.hpp>
+#include <utils/MappedFile.hpp>
 #include <OpenGL.hpp>
 #include <glm/glm.hpp>
 
+#include <string>
 #include <vector>
 
-class MeshVertexArray;
-class Texture;
-
 class Mesh
 {
 public:
+    // Map the cooked copy of the object, or parse it and cook it when outdated
     Mesh(MeshParams params);
     ~Mesh();
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
 
-    void updateMatrices(unsigned int instances, const glm::mat4* matrices);
-    void draw(unsigned int instances);
-    void drawAdjacency(unsigned int instances);
-    void bindTexture(GLuint diffuse, GLuint metallic, GLuint rough, GLuint normal);
     void debug();
 
+    // Diffuse, metallic, rough and normal texture files, empty when missing
+    const std::vector<std::string>& getTextures() const;
+    // Read the textures ahead, off the GL thread. Whoever uploads them may take them
+    void loadTextures();
+    std::vector<MipChain>& getLoadedTextures();
+
+    // Levels of detail, from the full mesh to the coarsest, all over the same
+    // vertexes. Errors are relative to the radius of the bounds around the origin
+    unsigned int getLodCount() const;
+    float getLodError(unsigned int lod) const;
+    float getRadius() const;
+
+    // Views of the mapped copy, or of the parsed data when it couldn't be mapped
+    Span<unsigned int> getIndexes(unsigned int lod = 0) const;
+    Span<unsigned int> getAdjacencyIndexes(unsigned int lod = 0) const;
+    Span<glm::vec4> getVertexes() const;
+    Span<glm::vec2> getUvs() const;
+    Span<glm::vec3> getNormals() const;
+    Span<glm::vec3> getTangents() const;
+    Span<glm::vec3> getBitangents() const;
+
 private:
 
+    void parse(const char* object);
     void verifyUVs();
     void initializeTriangleData();
-    void computeTrianglesPlaneEquations();
     void computeTrianglesTangents();
+    // Reorder triangles and vertexes for the GPU's caches
+    void optimize(std::vector<unsigned int>& positions);
+    void generateLods(const std::vector<unsigned int>& positions);
+    void generateAdjacencyIndexes(const std::vector<unsigned int>& lodIndexes, const std::vector<unsigned int>& positions, std::vector<unsigned int>& lodAdjacencyIndexes);
 
-    MeshVertexArray* vertexArray;
+    // A simplified level of detail
+    struct Lod
+    {
+        std::vector<unsigned int> indexes;
+        std::vector<unsigned int> adjacencyIndexes;
+        float error = 0.f;
+    };
 
     std::vector<unsigned int> indexes;
     std::vector<unsigned int> adjacencyIndexes;
     std::vector<glm::fvec3> trianglesTangents;
     std::vector<glm::fvec3> trianglesBitangents;
-    std::vector<glm::fvec4> trianglesPlaneEquations;
     std::vector<glm::uvec3> triangles;
     std::vector<glm::vec4> vertexes;
     std::vector<glm::vec2> uvs;
     std::vector<glm::vec3> normals;
-
-    Texture *diffuseTexture;
-    Texture *metallicTexture;
-    Texture *roughTexture;
-    Texture *normalTexture;
+    std::vector<Lod> lods;
+    float radius = 0.f;
+    MappedFile mapping;
+    MeshStreams streams;
+    std::vector<std::string> textures;
+    std::vector<MipChain> loadedTextures;
 };
 
@@ -0,0 +1,130 @@
+#include "MeshStreamer.hpp"
+#include "Mesh.hpp"
+#include "../utils/Store.hpp"
+#include "../../inc/utils/Utility.hpp"
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+namespace
+{
+    // Meshes nobody asked for yet come after every wanted one, in request order
+    const float unwanted = numeric_limits<float>::max();
+
+    string file(const char* filename)
+    {
+        return isEmpty(filename) ? string() : string(filename);
+    }
+}
+
+MeshStreamer::MeshStreamer(Store<const char*, Mesh, MeshParams>& _store)
+    : store(_store)
+{}
+
+MeshStreamer::~MeshStreamer()
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        requests.clear();
+    }
+    // Tasks still queued find nothing to load
+    threadPool().wait(tasks);
+    for (auto& mesh : loaded) {
+        delete mesh.second;
+    }
+}
+
+unsigned int MeshStreamer::request(const char* key, MeshParams params)
+{
+    const unsigned int meshId = store.reserve(key);
+    queue(key, meshId, false, params);
+    return meshId;
+}
+
+void MeshStreamer::reload(unsigned int meshId, MeshParams params)
+{
+    queue(nullptr, meshId, true, params);
+}
+
+void MeshStreamer::prioritize(unsigned int meshId, float priority)
+{
+    lock_guard<std::mutex> lock(mutex);
+    for (auto& request : requests) {
+        if (request.meshId == meshId) request.priority = priority;
+    }
+}
+
+const vector<unsigned int>& MeshStreamer::collect()
+{
+    vector<pair<Request, Mesh*>> meshes;
+    {
+        lock_guard<std::mutex> lock(mutex);
+        meshes.swap(loaded);
+        pending -= unsigned(meshes.size());
+    }
+
+    collected.clear();
+    for (auto& mesh : meshes) {
+        if (mesh.first.reload) {
+            store.replace(mesh.first.meshId, mesh.second);
+        } else {
+            store.insert(mesh.first.key, mesh.second);
+        }
+        collected.push_back(mesh.first.meshId);
+    }
+    return collected;
+}
+
+unsigned int MeshStreamer::getPending() const
+{
+    lock_guard<std::mutex> lock(mutex);
+    return pending;
+}
+
+void MeshStreamer::queue(const char* key, unsigned int meshId, bool reload, MeshParams params)
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        requests.push_back({key, meshId, unwanted, reload, {
+            file(params.object),
+            file(params.diffuseTexture),
+            file(params.metallicTexture),
+            file(params.roughTexture),
+            file(params.normalTexture)
+        }});
+        pending ++;
+    }
+    threadPool().enqueue([this]() { loadNext(); }, ThreadPool::BACKGROUND, &tasks);
+}
+
+void MeshStreamer::loadNext()
+{
+    Request request;
+    {
+        lock_guard<std::mutex> lock(mutex);
+        if (stopping || requests.empty()) return;
+
+        // Stable minimum, equal priorities keep their request order
+        auto next = min_element(requests.begin(), requests.end(), [](const Request& a, const Request& b) {
+            return a.priority < b.priority;
+        });
+        request = *next;
+        requests.erase(next);
+    }
+
+    MeshParams params {
+        request.files[0].c_str(),
+        request.files[1].c_str(),
+        request.files[2].c_str(),
+        request.files[3].c_str(),
+        request.files[4].c_str()
+    };
+    Mesh* mesh = new Mesh(params);
+    // A reloaded mesh keeps the material already uploaded
+    if (!request.reload) mesh->loadTextures();
+
+    lock_guard<std::mutex> lock(mutex);
+    loaded.push_back(make_pair(request, mesh));
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "MeshParams.hpp"
+#include "../utils/ThreadPool.hpp"
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+template <typename T, typename TT, typename TTT>
+class Store;
+class Mesh;
+
+// Loads meshes and their textures in the background, the most wanted first.
+// A requested mesh has an id right away, its store slot stays empty until
+// collected, the renderer draws a placeholder meanwhile. Loading runs on the
+// shared thread pool, after any more urgent task.
+class MeshStreamer
+{
+
+public:
+
+    MeshStreamer(Store<const char*, Mesh, MeshParams>& store);
+    ~MeshStreamer();
+
+    // Reserve the mesh's id and queue its loading
+    unsigned int request(const char* key, MeshParams params);
+    // Queue a new loading of a stored mesh whose object changed, it replaces the stored one once collected
+    void reload(unsigned int meshId, MeshParams params);
+    // The lower the priority, the sooner the mesh is loaded
+    void prioritize(unsigned int meshId, float priority);
+    // Insert the meshes loaded since the last call into the store, return their ids
+    const std::vector<unsigned int>& collect();
+
+    unsigned int getPending() const;
+
+private:
+
+    struct Request
+    {
+        const char* key;
+        unsigned int meshId;
+        float priority;
+        bool reload;
+        std::string files[5];
+    };
+
+    void queue(const char* key, unsigned int meshId, bool reload, MeshParams params);
+
+    // Each queued task loads the most wanted mesh at the time it runs
+    void loadNext();
+
+    Store<const char*, Mesh, MeshParams>& store;
+
+    ThreadPool::Group tasks;
+    std::vector<Request> requests;
+    std::vector<std::pair<Request, Mesh*>> loaded;
+    std::vector<unsigned int> collected;
+    unsigned int pending = 0;
+
+    mutable std::mutex mutex;
+    bool stopping = false;
+};
@@ -1,6 +1,35 @@
 #include "Program.hpp"
+#include "GLState.hpp"
+#include "UniformBuffer.hpp"
 #include "../../inc/utils/Utility.hpp"
 #include "../utils/Log.hpp"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <string.h>
+
+using namespace std;
+using namespace glm;
+
+unsigned int Program::uniformCalls = 0;
+unsigned int Program::elidedUniformCalls = 0;
+
+namespace
+{
+    bool isInteger(GLenum type)
+    {
+        switch (type) {
+            case GL_BOOL:
+            case GL_SAMPLER_2D:
+            case GL_SAMPLER_2D_ARRAY:
+            case GL_SAMPLER_2D_ARRAY_SHADOW:
+            case GL_SAMPLER_2D_SHADOW:
+            case GL_SAMPLER_CUBE:
+                return true;
+            default:
+                return false;
+        }
+    }
+}
 
 Program::Program(ProgramParams params)
     : reference(glCreateProgram())
@@ -9,38 +38,80 @@ Program::Program(ProgramParams params)
     , fs(GL_FRAGMENT_SHADER, reference)
 {
     if (!isEmpty(params.vertexShader)) {
-        vs.load(params.vertexShader);
+        linked = vs.load(params.vertexShader) && linked;
     }
     if (!isEmpty(params.geometryShader)) {
-        gs.load(params.geometryShader);
+        linked = gs.load(params.geometryShader) && linked;
     }
     if (!isEmpty(params.fragmentShader)) {
-        fs.load(params.fragmentShader);
+        linked = fs.load(params.fragmentShader) && linked;
     }
-    link();
+    // A missing stage could still link, it wouldn't be the program asked for
+    if (!linked) return;
+    linked = link();
+    if (linked) reflect();
 }
 
 Program::~Program()
 {
-    glDeleteProgram(reference);
+    glState().deleteProgram(reference);
 }
 
 void Program::use() const
 {
-    glUseProgram(reference);
+    glState().useProgram(reference);
 }
 
-void Program::idle() const
+bool Program::isLinked() const
 {
-    glUseProgram(0);
+    return linked;
 }
 
 GLint Program::getLocation(const char* variable) const
 {
-    return glGetUniformLocation(reference, variable);
+    const size_t found = find(variable);
+    return found < uniforms.size() ? uniforms[found].location : -1;
+}
+
+void Program::set(const char* variable, GLint value)
+{
+    Uniform* uniform = update(variable, GL_INT, &value, sizeof(value));
+    if (uniform) glUniform1i(uniform->location, value);
+}
+
+void Program::set(const char* variable, GLfloat value)
+{
+    Uniform* uniform = update(variable, GL_FLOAT, &value, sizeof(value));
+    if (uniform) glUniform1f(uniform->location, value);
+}
+
+void Program::set(const char* variable, const vec3& value)
+{
+    Uniform* uniform = update(variable, GL_FLOAT_VEC3, value_ptr(value), sizeof(value));
+    if (uniform) glUniform3fv(uniform->location, 1, value_ptr(value));
+}
+
+void Program::set(const char* variable, const vec4& value)
+{
+    Uniform* uniform = update(variable, GL_FLOAT_VEC4, value_ptr(value), sizeof(value));
+    if (uniform) glUniform4fv(uniform->location, 1, value_ptr(value));
+}
+
+void Program::set(const char* variable, const mat4& value)
+{
+    Uniform* uniform = update(variable, GL_FLOAT_MAT4, value_ptr(value), sizeof(value));
+    if (uniform) glUniformMatrix4fv(uniform->location, 1, GL_FALSE, value_ptr(value));
+}
+
+void Program::set(const char* variable, const mat4* values, GLsizei count)
+{
+    const size_t found = find(variable);
+    if (found == uniforms.size() || uniforms[found].type != GL_FLOAT_MAT4) return;
+    uniformCalls ++;
+    glUniformMatrix4fv(uniforms[found].location, count, GL_FALSE, value_ptr(values[0]));
 }
 
-void Program::link() const
+bool Program::link() const
 {
     GLint result;
     glLinkProgram(reference);
@@ -49,7 +120,73 @@ void Program::link() const
         GLchar Errorlog[1024];
         glGetProgramInfoLog(reference, sizeof(Errorlog), NULL, Errorlog);
         error(Errorlog);
-    } else {
-        glValidateProgram(reference);
+        return false;
+    }
+    glValidateProgram(reference);
+    return true;
+}
+
+void Program::reflect()
+{
+    UniformBuffer::bindBlocks(reference);
+
+    GLint count = 0;
+    GLchar name[256];
+    glGetProgramiv(reference, GL_ACTIVE_UNIFORMS, &count);
+
+    for (GLint i = 0; i < count; i ++) {
+        GLsizei length;
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(reference, GLuint(i), sizeof(name), &length, &size, &type, name);
+
+        // Uniforms in blocks have no location
+        GLint location = glGetUniformLocation(reference, name);
+        if (location < 0) continue;
+
+        // Arrays are reported as "name[0]"
+        string variable(name, size_t(length));
+        if (variable.size() > 3 && variable.compare(variable.size() - 3, 3, "[0]") == 0) {
+            variable.resize(variable.size() - 3);
+        }
+
+        Uniform uniform;
+        uniform.name = variable;
+        uniform.location = location;
+        uniform.type = type;
+        uniforms.push_back(uniform);
     }
+
+    sort(uniforms.begin(), uniforms.end(), [](const Uniform& a, const Uniform& b) { return a.name < b.name; });
+}
+
+size_t Program::find(const char* variable) const
+{
+    auto found = lower_bound(uniforms.begin(), uniforms.end(), variable, [](const Uniform& uniform, const char* name) {
+        return strcmp(uniform.name.c_str(), name) < 0;
+    });
+    return found != uniforms.end() && strcmp(found->name.c_str(), variable) == 0 ? size_t(found - uniforms.begin()) : uniforms.size();
+}
+
+Program::Uniform* Program::update(const char* variable, GLenum type, const void* value, size_t size)
+{
+    const size_t found = find(variable);
+    if (found == uniforms.size()) return nullptr;
+
+    // Samplers and booleans are set as integers
+    Uniform& uniform = uniforms[found];
+    if (uniform.type != type && !(type == GL_INT && isInteger(uniform.type))) {
+        if (!uniform.mismatched) error("Program: uniform", variable, "is not set with its declared type");
+        uniform.mismatched = true;
+        return nullptr;
+    }
+    if (uniform.set && memcmp(uniform.value, value, size) == 0) {
+        elidedUniformCalls ++;
+        return nullptr;
+    }
+
+    memcpy(uniform.value, value, size);
+    uniform.set = true;
+    uniformCalls ++;
+    return &uniform;
 }
@@ -2,6 +2,9 @@
 #include "ProgramParams.hpp"
 #include "Shader.hpp"
 #include <OpenGL.hpp>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
 
 class Program
 {
@@ -14,20 +17,53 @@ public:
     ~Program();
 
     void use() const;
-    void idle() const;
+    // Whether every shader compiled and the program linked
+    bool isLinked() const;
 
     GLint getLocation(const char* variable) const;
 
+    // Upload a uniform of the program in use, unless it already holds that value
+    // or the shader declares it with another type
+    void set(const char* variable, GLint value);
+    void set(const char* variable, GLfloat value);
+    void set(const char* variable, const glm::vec3& value);
+    void set(const char* variable, const glm::vec4& value);
+    void set(const char* variable, const glm::mat4& value);
+    // Arrays don't fit the cached value, they are always uploaded
+    void set(const char* variable, const glm::mat4* values, GLsizei count);
+
+    // Uniform uploads issued and skipped by every program since the last reset
+    static unsigned int uniformCalls;
+    static unsigned int elidedUniformCalls;
+
 private:
 
+    struct Uniform
+    {
+        std::string name;
+        GLint location;
+        GLenum type;
+        bool set = false;
+        bool mismatched = false;
+        GLfloat value[16];
+    };
+
     Program();
 
     GLuint reference;
+    bool linked = true;
 
     Shader vs;
     Shader gs;
     Shader fs;
 
-    void link() const;
+    // Sorted by name, looked up without building a string on every set
+    std::vector<Uniform> uniforms;
+
+    bool link() const;
+    void reflect();
+    // Index of the uniform, the count when the program doesn't have it
+    size_t find(const char* variable) const;
+    Uniform* update(const char* variable, GLenum type, const void* value, size_t size);
 
 };
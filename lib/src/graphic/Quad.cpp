@@ -1,4 +1,5 @@
 #include "Quad.hpp"
+#include "GLState.hpp"
 
 Quad::Quad()
 {
@@ -12,7 +13,7 @@ Quad::Quad()
 
     glGenVertexArrays(1, &quadVAO);
     glGenBuffers(1, &quadVBO);
-    glBindVertexArray(quadVAO);
+    glState().bindVertexArray(quadVAO);
     glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
@@ -23,7 +24,6 @@ Quad::Quad()
 
 void Quad::draw()
 {
-    glBindVertexArray(quadVAO);
+    glState().bindVertexArray(quadVAO);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
 }
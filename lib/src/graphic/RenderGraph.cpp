@@ -0,0 +1,364 @@
+#include "RenderGraph.hpp"
+#include "GLState.hpp"
+#include "../utils/Log.hpp"
+#include <algorithm>
+#include <set>
+
+using namespace std;
+
+const unsigned int RenderGraph::backbuffer;
+
+namespace
+{
+    const GLbitfield depthStencilBits = GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
+
+    // Size of a texel of the formats attachments use, as drivers store them:
+    // 3 component and 24 bit depth formats are padded to 4 components or bytes
+    unsigned int texelBytes(GLenum internalFormat)
+    {
+        switch (internalFormat) {
+            case GL_RGBA16F:
+            case GL_RGB16F: return 8;
+            case GL_RGBA8:
+            case GL_RGB8:
+            case GL_RGB:
+            case GL_RG16:
+            case GL_DEPTH24_STENCIL8:
+            case GL_DEPTH_COMPONENT24: return 4;
+            case GL_RG8: return 2;
+            default: return 0;
+        }
+    }
+
+    bool usesDepthStencil(const RenderGraph::Pass& pass)
+    {
+        return pass.depth != RenderGraph::NONE || pass.stencil != RenderGraph::NONE || (pass.clear & depthStencilBits);
+    }
+}
+
+RenderGraph::RenderGraph()
+    : attachments(1) // backbuffer
+{
+}
+
+void RenderGraph::resize(GLsizei _width, GLsizei _height)
+{
+    width = _width;
+    height = _height;
+    attachments[backbuffer].width = width;
+    attachments[backbuffer].height = height;
+}
+
+GLsizei RenderGraph::getWidth() const
+{
+    return width;
+}
+
+GLsizei RenderGraph::getHeight() const
+{
+    return height;
+}
+
+unsigned int RenderGraph::getBytesPerPixel() const
+{
+    return bytesPerPixel;
+}
+
+RenderGraph::~RenderGraph()
+{
+    release();
+}
+
+unsigned int RenderGraph::addAttachment(GLenum internalFormat, GLenum format, GLenum type, GLsizei _width, GLsizei _height, GLsizei layers)
+{
+    Attachment attachment;
+    attachment.internalFormat = internalFormat;
+    attachment.format = format;
+    attachment.type = type;
+    attachment.width = _width ? _width : width;
+    attachment.height = _height ? _height : height;
+    attachment.layers = layers;
+    attachments.push_back(attachment);
+    return unsigned(attachments.size() - 1);
+}
+
+unsigned int RenderGraph::addDepthStencil()
+{
+    return addAttachment(GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8);
+}
+
+unsigned int RenderGraph::addShadowMap(GLsizei size, GLsizei layers)
+{
+    return addAttachment(GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT, size, size, layers);
+}
+
+void RenderGraph::addPass(const Pass& pass)
+{
+    passes.push_back(pass);
+}
+
+void RenderGraph::clear()
+{
+    release();
+    attachments.resize(1);
+    passes.clear();
+    kept.clear();
+    framebuffers.clear();
+}
+
+void RenderGraph::compile()
+{
+    release();
+    cull();
+    allocate();
+
+    framebuffers.assign(passes.size(), 0);
+    for (unsigned int p = 0; p < passes.size(); p ++) {
+        if (kept[p]) framebuffers[p] = framebuffer(passes[p]);
+    }
+
+    info("RenderGraph:", count(kept.begin(), kept.end(), true), "passes,", count(kept.begin(), kept.end(), false), "culled,", textures.size(), "textures for", attachments.size() - 1, "attachments,", bytesPerPixel, "bytes per pixel");
+}
+
+void RenderGraph::execute()
+{
+    for (unsigned int p = 0; p < passes.size(); p ++) {
+        if (!kept[p]) continue;
+        const Pass& pass = passes[p];
+
+        glState().bindFramebuffer(framebuffers[p]);
+        const Attachment& size = target(pass);
+        glState().viewport(0, 0, size.width, size.height);
+
+        if (pass.depth != NONE) {
+            glState().enable(GL_DEPTH_TEST);
+            glState().depthFunc(pass.depthFunc);
+        } else {
+            glState().disable(GL_DEPTH_TEST);
+        }
+        glState().depthMask(pass.depth == WRITE || (pass.clear & GL_DEPTH_BUFFER_BIT) ? GL_TRUE : GL_FALSE);
+
+        if (pass.stencil != NONE) {
+            glState().enable(GL_STENCIL_TEST);
+            glState().stencilFunc(pass.stencilFunc, pass.stencilRef, ~0u);
+            glState().stencilOpSeparate(GL_FRONT, pass.stencilFront.fail, pass.stencilFront.depthFail, pass.stencilFront.depthPass);
+            glState().stencilOpSeparate(GL_BACK, pass.stencilBack.fail, pass.stencilBack.depthFail, pass.stencilBack.depthPass);
+        } else {
+            glState().disable(GL_STENCIL_TEST);
+        }
+
+        if (pass.cull) {
+            glState().enable(GL_CULL_FACE);
+        } else {
+            glState().disable(GL_CULL_FACE);
+        }
+
+        if (pass.depthClamp) {
+            glState().enable(GL_DEPTH_CLAMP);
+        } else {
+            glState().disable(GL_DEPTH_CLAMP);
+        }
+
+        // Passes may scissor their draws, never the clears
+        glState().disable(GL_SCISSOR_TEST);
+
+        const unsigned int mask = pass.outputs.empty() ? 0 : pass.colorMask;
+        glState().colorMask(mask & 1 ? GL_TRUE : GL_FALSE, mask & 2 ? GL_TRUE : GL_FALSE, mask & 4 ? GL_TRUE : GL_FALSE, mask & 8 ? GL_TRUE : GL_FALSE);
+
+        if (pass.clear) glClear(pass.clear);
+
+        for (unsigned int i = 0; i < pass.inputs.size(); i ++) {
+            const Attachment& input = attachments[pass.inputs[i]];
+            glState().bindTexture(GL_TEXTURE0 + i, input.layers ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D, input.texture);
+        }
+
+        pass.execute();
+    }
+}
+
+GLenum RenderGraph::depthAttachment(unsigned int resource) const
+{
+    switch (attachments[resource].format) {
+        case GL_DEPTH_STENCIL: return GL_DEPTH_STENCIL_ATTACHMENT;
+        case GL_DEPTH_COMPONENT: return GL_DEPTH_ATTACHMENT;
+        default: return GL_NONE;
+    }
+}
+
+const RenderGraph::Attachment& RenderGraph::target(const Pass& pass) const
+{
+    if (!pass.outputs.empty()) return attachments[pass.outputs[0]];
+    return attachments[usesDepthStencil(pass) ? pass.depthStencil : backbuffer];
+}
+
+bool RenderGraph::writes(const Pass& pass, unsigned int resource) const
+{
+    if (find(pass.outputs.begin(), pass.outputs.end(), resource) != pass.outputs.end()) return true;
+    return resource == pass.depthStencil && (pass.depth == WRITE || pass.stencil == WRITE || (pass.clear & depthStencilBits));
+}
+
+void RenderGraph::cull()
+{
+    // Walk back from the backbuffer, keeping the passes writing something read later
+    set<unsigned int> needed {backbuffer};
+    kept.assign(passes.size(), false);
+
+    for (unsigned int p = unsigned(passes.size()); p -- > 0;) {
+        const Pass& pass = passes[p];
+
+        for (auto resource : needed) {
+            if (writes(pass, resource)) kept[p] = true;
+        }
+        if (!kept[p]) continue;
+
+        // Cleared resources don't depend on what earlier passes wrote
+        if (pass.clear & GL_COLOR_BUFFER_BIT) {
+            for (auto output : pass.outputs) needed.erase(output);
+        }
+        if ((pass.clear & depthStencilBits) == depthStencilBits) {
+            needed.erase(pass.depthStencil);
+        }
+
+        for (auto input : pass.inputs) needed.insert(input);
+        if (!(pass.clear & GL_COLOR_BUFFER_BIT)) {
+            for (auto output : pass.outputs) needed.insert(output);
+        }
+        if (usesDepthStencil(pass) && (pass.clear & depthStencilBits) != depthStencilBits) {
+            needed.insert(pass.depthStencil);
+        }
+    }
+}
+
+void RenderGraph::allocate()
+{
+    for (auto& attachment : attachments) {
+        attachment.firstUse = attachment.lastUse = -1;
+        attachment.texture = 0;
+    }
+    bytesPerPixel = 0;
+
+    for (unsigned int p = 0; p < passes.size(); p ++) {
+        if (!kept[p]) continue;
+        vector<unsigned int> resources(passes[p].inputs);
+        resources.insert(resources.end(), passes[p].outputs.begin(), passes[p].outputs.end());
+        if (usesDepthStencil(passes[p])) resources.push_back(passes[p].depthStencil);
+
+        for (auto resource : resources) {
+            Attachment& attachment = attachments[resource];
+            if (attachment.firstUse < 0) attachment.firstUse = int(p);
+            attachment.lastUse = int(p);
+        }
+    }
+
+    // Attachments used one after the other share a texture when their formats match
+    vector<unsigned int> order;
+    for (unsigned int a = 1; a < attachments.size(); a ++) {
+        if (attachments[a].firstUse >= 0) order.push_back(a);
+    }
+    sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) { return attachments[a].firstUse < attachments[b].firstUse; });
+
+    vector<unsigned int> owners; // last attachment using each texture
+    for (auto a : order) {
+        Attachment& attachment = attachments[a];
+        for (unsigned int t = 0; t < textures.size(); t ++) {
+            const Attachment& owner = attachments[owners[t]];
+            if (owner.lastUse < attachment.firstUse && owner.internalFormat == attachment.internalFormat
+                && owner.width == attachment.width && owner.height == attachment.height && owner.layers == attachment.layers) {
+                attachment.texture = textures[t];
+                owners[t] = a;
+                break;
+            }
+        }
+        if (attachment.texture) continue;
+
+        GLuint texture;
+        const GLenum target = attachment.layers ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+        glGenTextures(1, &texture);
+        glState().bindTexture(GL_TEXTURE0, target, texture);
+        if (attachment.layers) {
+            glTexImage3D(target, 0, GLint(attachment.internalFormat), attachment.width, attachment.height, attachment.layers, 0, attachment.format, attachment.type, NULL);
+        } else {
+            glTexImage2D(target, 0, GLint(attachment.internalFormat), attachment.width, attachment.height, 0, attachment.format, attachment.type, NULL);
+        }
+
+        // Shadow maps are compared against in the lookups, which filter the results
+        const GLint filter = attachment.format == GL_DEPTH_COMPONENT ? GL_LINEAR : GL_NEAREST;
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, filter);
+        if (attachment.format == GL_DEPTH_COMPONENT) {
+            glTexParameteri(target, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+            glTexParameteri(target, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+            glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+
+        attachment.texture = texture;
+        textures.push_back(texture);
+        owners.push_back(a);
+        if (attachment.width == width && attachment.height == height && !attachment.layers) {
+            bytesPerPixel += texelBytes(attachment.internalFormat);
+        }
+    }
+}
+
+GLuint RenderGraph::framebuffer(const Pass& pass)
+{
+    if (pass.outputs.size() == 1 && pass.outputs[0] == backbuffer) return 0;
+
+    vector<unsigned int> key(pass.outputs);
+    key.push_back(usesDepthStencil(pass) ? pass.depthStencil : backbuffer);
+    key.push_back(unsigned(pass.layer));
+
+    auto found = framebuffersByAttachments.find(key);
+    if (found != framebuffersByAttachments.end()) return found->second;
+
+    GLuint reference;
+    glGenFramebuffers(1, &reference);
+    glState().bindFramebuffer(reference);
+
+    vector<GLenum> drawBuffers;
+    for (unsigned int i = 0; i < pass.outputs.size(); i ++) {
+        attach(GL_COLOR_ATTACHMENT0 + i, attachments[pass.outputs[i]], pass.layer);
+        drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + i);
+    }
+    if (drawBuffers.empty()) {
+        // GL 3.3 also wants no read buffer for depth only framebuffers to be complete
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    } else {
+        glDrawBuffers(GLsizei(drawBuffers.size()), drawBuffers.data());
+    }
+
+    if (usesDepthStencil(pass) && depthAttachment(pass.depthStencil) != GL_NONE) {
+        attach(depthAttachment(pass.depthStencil), attachments[pass.depthStencil], pass.layer);
+    }
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        error("Framebuffer failed for pass", pass.name);
+    }
+
+    framebuffersByAttachments[key] = reference;
+    return reference;
+}
+
+void RenderGraph::attach(GLenum point, const Attachment& attachment, GLint layer)
+{
+    if (attachment.layers) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, point, attachment.texture, 0, layer);
+    } else {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, point, GL_TEXTURE_2D, attachment.texture, 0);
+    }
+}
+
+void RenderGraph::release()
+{
+    glState().bindFramebuffer(0);
+    for (auto& framebuffer : framebuffersByAttachments) {
+        glDeleteFramebuffers(1, &framebuffer.second);
+    }
+    for (auto texture : textures) {
+        glState().deleteTexture(texture);
+    }
+    framebuffersByAttachments.clear();
+    textures.clear();
+}
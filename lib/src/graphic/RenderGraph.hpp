@@ -0,0 +1,113 @@
+#pragma once
+#include <OpenGL.hpp>
+#include <functional>
+#include <map>
+#include <vector>
+
+// Frame pipeline described as passes declaring the attachments they read and
+// write. Compiling it culls the passes nothing depends on, gives attachments
+// whose lifetimes don't overlap the same texture and creates the framebuffers;
+// executing it applies each pass' state, clears and inputs before running it.
+class RenderGraph
+{
+
+public:
+
+    enum Usage { NONE, READ, WRITE };
+
+    // Resource standing for the default framebuffer, color and depth
+    static const unsigned int backbuffer = 0;
+
+    struct StencilOp
+    {
+        GLenum fail = GL_KEEP;
+        GLenum depthFail = GL_KEEP;
+        GLenum depthPass = GL_KEEP;
+    };
+
+    struct Pass
+    {
+        const char* name = "";
+        // Sampled attachments, bound to texture units 0, 1, ... in that order
+        std::vector<unsigned int> inputs;
+        // Color attachments written, or backbuffer alone
+        std::vector<unsigned int> outputs;
+        unsigned int depthStencil = backbuffer;
+        // Layer of the array attachments written
+        GLint layer = 0;
+        Usage depth = NONE;
+        Usage stencil = NONE;
+        GLbitfield clear = 0;
+        // Channels of the color attachments written, red being bit 0
+        unsigned int colorMask = 0xF;
+
+        GLenum depthFunc = GL_LESS;
+        bool cull = true;
+        // Geometry past the near and far planes is clamped instead of clipped
+        bool depthClamp = false;
+        GLenum stencilFunc = GL_ALWAYS;
+        GLint stencilRef = 0;
+        StencilOp stencilFront;
+        StencilOp stencilBack;
+
+        std::function<void()> execute;
+    };
+
+    RenderGraph();
+    ~RenderGraph();
+
+    // Size of the backbuffer and of the attachments not given one, set before adding them
+    void resize(GLsizei width, GLsizei height);
+
+    // Attachments are the size of the graph unless given one, array textures when given layers
+    unsigned int addAttachment(GLenum internalFormat, GLenum format, GLenum type, GLsizei width = 0, GLsizei height = 0, GLsizei layers = 0);
+    unsigned int addDepthStencil();
+    // Depth only array sampled with comparison, filtered over 2x2 texels
+    unsigned int addShadowMap(GLsizei size, GLsizei layers);
+    void addPass(const Pass& pass);
+    // Drop the passes and attachments to describe the pipeline again
+    void clear();
+
+    void compile();
+    void execute();
+
+    GLsizei getWidth() const;
+    GLsizei getHeight() const;
+    // Memory of the textures the size of the backbuffer, per pixel
+    unsigned int getBytesPerPixel() const;
+
+private:
+
+    struct Attachment
+    {
+        GLenum internalFormat = 0;
+        GLenum format = 0;
+        GLenum type = 0;
+        GLsizei width = 0;
+        GLsizei height = 0;
+        GLsizei layers = 0;
+        int firstUse = -1;
+        int lastUse = -1;
+        GLuint texture = 0;
+    };
+
+    GLenum depthAttachment(unsigned int resource) const;
+    const Attachment& target(const Pass& pass) const;
+    bool writes(const Pass& pass, unsigned int resource) const;
+    void cull();
+    void allocate();
+    void attach(GLenum point, const Attachment& attachment, GLint layer);
+    GLuint framebuffer(const Pass& pass);
+    void release();
+
+    GLsizei width = 0;
+    GLsizei height = 0;
+    unsigned int bytesPerPixel = 0;
+
+    std::vector<Attachment> attachments;
+    std::vector<Pass> passes;
+    std::vector<bool> kept;
+    std::vector<GLuint> framebuffers;
+    std::vector<GLuint> textures;
+    std::map<std::vector<unsigned int>, GLuint> framebuffersByAttachments;
+};
@@ -2,18 +2,24 @@
 #include "ProgramParams.hpp"
 #include "MeshParams.hpp"
 #include "Renderer.hpp"
-#include "Model.hpp"
 #include "Camera.hpp"
+#include "GLState.hpp"
 #include "../utils/Store.hpp"
 #include "../utils/Log.hpp"
-#include "../utils/Aggregator.hpp"
-#include <glm/gtc/type_ptr.hpp>
+#include "../utils/Transforms.hpp"
+#include "../utils/ShadowCulling.hpp"
+#include "DrawList.hpp"
 #include <glm/glm.hpp>
 #include <OpenGL.hpp>
+#include <algorithm>
+#include <string.h>
 
 using namespace std;
 using namespace glm;
 
+const unsigned int Renderer::maxShadowCascades;
+const GLsizei Renderer::shadowMapSize;
+
 Renderer::Renderer(
         Store<const char*, Mesh, MeshParams>& _meshStore,
         Store<const char*, Program, ProgramParams>& _programStore,
@@ -22,8 +28,12 @@ Renderer::Renderer(
     : meshStore(_meshStore)
     , programStore(_programStore)
     , cubemapStore(_cubemapStore)
+    , instanceBuffer(GL_ARRAY_BUFFER, 1024 * sizeof(GLfloat) * Transforms::matrixFloats)
+    , indirectBuffer(GL_COPY_WRITE_BUFFER, 64 * sizeof(DrawElementsIndirectCommand)) // GL_DRAW_INDIRECT_BUFFER is not a GL 3.3 target
     , camera(new Camera(0.f, -5.f, 5.f, float(M_PI) * -0.25f, 0.f, 0.f))
 {
+    glGenQueries(shadowQueryCount, shadowQueries);
+
     // TODO make this date driven
     directionalLight.color = vec3(1.0, 0.9, 0.8);
     directionalLight.ambiant = vec3(0.44, 0.24, 0.04);
@@ -32,112 +42,498 @@ Renderer::Renderer(
 
 Renderer::~Renderer()
 {
+    glDeleteQueries(shadowQueryCount, shadowQueries);
     delete camera;
 }
 
 void Renderer::setup(RendererParams _params)
 {
     params = _params;
+    buildGraph();
+
+    const char* implementation = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    if (implementation && strstr(implementation, "llvmpipe")) {
+        setShadowVolumeMode(CPU);
+    }
 }
 
-void Renderer::render(Aggregator<Model> &models)
+void Renderer::buildGraph()
+{
+    graph.clear();
+    graph.resize(params.width, params.height);
+
+    // Positions are rebuilt from depth, normals are octahedral encoded and the
+    // shadow mask is packed with the metallicness and roughness
+    unsigned int depthStencil = graph.addDepthStencil();
+    unsigned int gNormal = graph.addAttachment(GL_RG16, GL_RG, GL_UNSIGNED_SHORT);
+    unsigned int gDiffuse = graph.addAttachment(GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE);
+    unsigned int gMaterial = graph.addAttachment(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    const unsigned int shadowChannel = 4; // blue
+
+    RenderGraph::Pass depth;
+    depth.name = "depth";
+    depth.depthStencil = depthStencil;
+    depth.depth = RenderGraph::WRITE;
+    depth.clear = GL_DEPTH_BUFFER_BIT;
+    depth.depthFunc = GL_LEQUAL;
+    depth.execute = [this]() { depthPass(); };
+    graph.addPass(depth);
+
+    // Leaves every pixel in shadow, the shadow passes then write where it is lit
+    RenderGraph::Pass geometryBuffer;
+    geometryBuffer.name = "geometry buffer";
+    geometryBuffer.outputs = {gNormal, gDiffuse, gMaterial};
+    geometryBuffer.depthStencil = depthStencil;
+    geometryBuffer.depth = RenderGraph::READ;
+    geometryBuffer.clear = GL_COLOR_BUFFER_BIT;
+    geometryBuffer.depthFunc = GL_LEQUAL;
+    geometryBuffer.execute = [this]() { geometryPass(); };
+    graph.addPass(geometryBuffer);
+
+    if (shadowTechnique == SHADOW_VOLUMES) {
+        // Z-pass stencil shadow volumes
+        RenderGraph::Pass shadowVolume;
+        shadowVolume.name = "shadow volume";
+        shadowVolume.depthStencil = depthStencil;
+        shadowVolume.depth = RenderGraph::READ;
+        shadowVolume.stencil = RenderGraph::WRITE;
+        shadowVolume.clear = GL_STENCIL_BUFFER_BIT;
+        shadowVolume.cull = false;
+        shadowVolume.depthClamp = true;
+        shadowVolume.stencilFront.depthPass = GL_INCR_WRAP;
+        shadowVolume.stencilBack.depthPass = GL_DECR_WRAP;
+        shadowVolume.execute = [this]() { shadowVolumePass(); };
+        graph.addPass(shadowVolume);
+
+        RenderGraph::Pass shadowImprint;
+        shadowImprint.name = "shadow imprint";
+        shadowImprint.outputs = {gMaterial};
+        shadowImprint.colorMask = shadowChannel;
+        shadowImprint.depthStencil = depthStencil;
+        shadowImprint.depth = RenderGraph::READ;
+        shadowImprint.stencil = RenderGraph::READ;
+        shadowImprint.depthFunc = GL_LEQUAL;
+        shadowImprint.stencilFunc = GL_EQUAL;
+        shadowImprint.execute = [this]() { shadowImprintPass(); };
+        graph.addPass(shadowImprint);
+    } else {
+        // One layer per cascade, casters before a cascade are clamped onto its
+        // near plane. Both faces are drawn, open meshes would leak otherwise
+        unsigned int shadowMap = graph.addShadowMap(shadowMapSize, GLsizei(shadowCascadeCount));
+        for (unsigned int cascade = 0; cascade < shadowCascadeCount; cascade ++) {
+            RenderGraph::Pass shadowMapLayer;
+            shadowMapLayer.name = "shadow map";
+            shadowMapLayer.depthStencil = shadowMap;
+            shadowMapLayer.layer = GLint(cascade);
+            shadowMapLayer.depth = RenderGraph::WRITE;
+            shadowMapLayer.clear = GL_DEPTH_BUFFER_BIT;
+            shadowMapLayer.cull = false;
+            shadowMapLayer.depthClamp = true;
+            shadowMapLayer.execute = [this, cascade]() { shadowMapPass(cascade); };
+            graph.addPass(shadowMapLayer);
+        }
+
+        RenderGraph::Pass shadowMapImprint;
+        shadowMapImprint.name = "shadow map imprint";
+        shadowMapImprint.inputs = {depthStencil, gNormal, shadowMap};
+        shadowMapImprint.outputs = {gMaterial};
+        shadowMapImprint.colorMask = shadowChannel;
+        shadowMapImprint.execute = [this]() { shadowMapImprintPass(); };
+        graph.addPass(shadowMapImprint);
+    }
+
+    RenderGraph::Pass lighting;
+    lighting.name = "lighting";
+    lighting.inputs = {depthStencil, gNormal, gDiffuse, gMaterial};
+    lighting.outputs = {RenderGraph::backbuffer};
+    lighting.depth = RenderGraph::WRITE;
+    lighting.clear = GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT;
+    lighting.depthFunc = GL_LEQUAL;
+    lighting.execute = [this]() { lightingPass(); };
+    graph.addPass(lighting);
+
+    graph.compile();
+}
+
+void Renderer::render(DrawList& drawList)
 {
     // Setup
-    glFrontFace(GL_CW);
-    glCullFace(GL_FRONT);
-
-    uploadMatrices(models);
-
-    // Off screen rendering
-    gBuffer.bind();
-
-    // Render depth
-    glEnable(GL_DEPTH_TEST);
-    glDepthMask(GL_TRUE);
-    glClear(GL_DEPTH_BUFFER_BIT);
-    glDepthFunc(GL_LEQUAL);
-    depthPass(models);
-
-    // Render shadows
-    glDepthMask(GL_FALSE);
-    glDisable(GL_CULL_FACE);
-    glEnable(GL_STENCIL_TEST);
-    glClear(GL_STENCIL_BUFFER_BIT);
-    glStencilFunc(GL_ALWAYS, 0, 0xFFFFFFFFL);
-    glStencilOpSeparate(GL_FRONT,GL_KEEP,GL_KEEP,GL_INCR_WRAP);
-    glStencilOpSeparate(GL_BACK ,GL_KEEP,GL_KEEP,GL_DECR_WRAP);
-    glDepthFunc(GL_LESS);
-    shadowVolumePass(models);
-
-    // Imprint shadows
-    glEnable(GL_CULL_FACE);
-    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-    glStencilFunc(GL_EQUAL, 0, 0xFFFFFFFFL);
-    glDepthFunc(GL_LEQUAL);
-    glColorMask(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
-    glClear(GL_COLOR_BUFFER_BIT);
-    shadowImprintPass();
-
-    // Render scene
-    glDisable(GL_STENCIL_TEST);
-    geometryPass(models);
-
-    // On screen rendering
-    gBuffer.idle();
-
-    // Render lighting
-    glDepthMask(GL_TRUE);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    lightingPass();
-
-    // Reset states
-    glColorMask(GL_ZERO, GL_ZERO, GL_ZERO, GL_ZERO);
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_CULL_FACE);
-}
-
-void Renderer::uploadMatrices(Aggregator<Model> &models)
-{
-    for (unsigned int t = 0; t < models.size(); t ++) {
-        unsigned int totalModels = models.size(t);
-        vector<mat4> matrices;
-        matrices.reserve(models.size(t));
-        for (unsigned int i = 0; i < totalModels; i++) {
-            matrices.push_back(models.get(t)->at(i).getProduct());
+    statistics.reset();
+    Program::uniformCalls = 0;
+    Program::elidedUniformCalls = 0;
+    glState().calls = 0;
+    glState().redundantCalls = 0;
+    glState().frontFace(GL_CW);
+    glState().cullFace(GL_FRONT);
+
+    uniforms.update(*camera, directionalLight);
+    loadMeshes(drawList);
+    selectLods(drawList);
+    drawList.sort(camera->getRotation() * camera->getTranslation(), meshesMaterials);
+    if (shadowTechnique == SHADOW_VOLUMES) {
+        classifyShadowCasters(drawList);
+    } else {
+        fitShadowCascades();
+    }
+    uploadInstances(drawList);
+
+    graph.execute();
+
+    // The streamed regions can be reused once these draw calls are done
+    instanceBuffer.fence();
+    if (geometry.isMultiDrawIndirect()) indirectBuffer.fence();
+    if (shadowTechnique == SHADOW_VOLUMES) shadowExtrusion.fence();
+
+    statistics.shadowMilliseconds = shadowTimer.getMilliseconds();
+    statistics.geometryMilliseconds = geometryTimer.getMilliseconds();
+    statistics.lightingMilliseconds = lightingTimer.getMilliseconds();
+    statistics.uniformCalls = Program::uniformCalls;
+    statistics.elidedUniformCalls = Program::elidedUniformCalls;
+    statistics.stateCalls = glState().calls;
+    statistics.redundantStateCalls = glState().redundantCalls;
+    reportStatistics();
+}
+
+void Renderer::load(ThreadPool& pool)
+{
+    for (unsigned int meshId = 0; meshId < meshStore.size(); meshId ++) {
+        addMesh(meshId);
+    }
+    uploadMeshes(&pool);
+}
+
+void Renderer::loadMeshes(DrawList& drawList)
+{
+    // Meshes still streaming in have an empty slot, the placeholder stands for them
+    bool missing = false;
+    resolvedMeshes.resize(meshStore.size());
+    for (unsigned int meshId = 0; meshId < resolvedMeshes.size(); meshId ++) {
+        resolvedMeshes[meshId] = meshStore.getById(meshId) ? meshId : params.placeholderMeshId;
+    }
+
+    const CameraBlock& view = uniforms.getCamera();
+    const float outOfView = 1e6f;
+    meshesWants.assign(meshStore.size(), -1.f);
+    wantedMeshes.clear();
+
+    const vector<unsigned int>& meshes = drawList.getMeshes();
+    for (unsigned int i = 0; i < meshes.size(); i ++) {
+        const unsigned int meshId = meshes[i];
+        if (resolvedMeshes[meshId] == meshId) continue;
+        missing = true;
+
+        // Instances are tested as points with a margin, their bounds are unknown until loaded
+        const vec3 position = drawList.getPosition(i);
+        float want = distance(position, vec3(view.position));
+        for (auto& plane : view.frustumPlanes) {
+            if (dot(vec3(plane), position) + plane.w < -1.f && vec3(plane) != vec3(0.f)) {
+                want += outOfView;
+                break;
+            }
+        }
+        if (meshesWants[meshId] < 0.f || want < meshesWants[meshId]) meshesWants[meshId] = want;
+    }
+
+    if (missing) {
+        for (unsigned int meshId = 0; meshId < meshesWants.size(); meshId ++) {
+            if (meshesWants[meshId] >= 0.f) wantedMeshes.push_back(make_pair(meshId, meshesWants[meshId]));
         }
-        meshStore.getById(t)->updateMatrices(totalModels, matrices.data());
+        drawList.remap(resolvedMeshes);
+    }
+
+    // Meshes which were not loaded ahead are uploaded when first drawn
+    for (unsigned int meshId : drawList.getMeshes()) {
+        addMesh(meshId);
     }
+    uploadMeshes(nullptr);
 }
 
-void Renderer::depthPass(Aggregator<Model> &models)
+void Renderer::selectLods(DrawList& drawList)
 {
-    unique_ptr<Program>& program = programStore.getById(params.fillingProgramId);
-    program->use();
+    // Each instance is drawn with the coarsest level whose error, projected
+    // at the instance's depth, stays under a pixel
+    const CameraBlock& view = uniforms.getCamera();
+    const float pixelsPerUnit = view.projection[1][1] * float(graph.getHeight()) * 0.5f;
+    const float maxPixelError = 1.f;
+
+    const vector<unsigned int>& meshes = drawList.getMeshes();
+    for (unsigned int i = 0; i < meshes.size(); i ++) {
+        const unsigned int meshId = meshes[i];
+        const unsigned int lodCount = geometry.getLodCount(meshId);
+        if (lodCount < 2) continue;
+
+        const vec3 scale = abs(drawList.getScale(i));
+        const float radius = geometry.getRadius(meshId) * std::max(scale.x, std::max(scale.y, scale.z));
+        const float depth = std::max(distance(drawList.getPosition(i), vec3(view.position)) - radius, 1e-3f);
+
+        unsigned int lod = 0;
+        while (lod + 1 < lodCount && geometry.getLodError(meshId, lod + 1) * radius / depth * pixelsPerUnit <= maxPixelError) {
+            lod ++;
+        }
+        drawList.setLod(i, lod);
+    }
+}
+
+void Renderer::classifyShadowCasters(const DrawList& drawList)
+{
+    const CameraBlock& view = uniforms.getCamera();
+    const vec3 light(directionalLight.direction);
+
+    // Corner of the near plane, from the projection: near is where depth is -1
+    const float near = view.projection[3][2] / (view.projection[2][2] - 1.f);
+    const float cameraRadius = length(vec3(near / view.projection[0][0], near / view.projection[1][1], near));
+
+    const Transforms& transforms = drawList.getTransforms();
+    shadowTests.resize(drawList.size());
+    vec4 screen(1.f, 1.f, -1.f, -1.f);
+    for (auto& batch : drawList.getBatches()) {
+        for (unsigned int i = batch.first; i < batch.first + batch.count; i ++) {
+            const vec3 scale = abs(transforms.getScale(i));
+            const float radius = geometry.getRadius(batch.meshId) * std::max(scale.x, std::max(scale.y, scale.z));
+            const vec3 center = transforms.getPosition(i);
+            shadowTests[i] = classifyShadowCaster(view.frustumPlanes, vec3(view.position), cameraRadius, center, radius, light);
+
+            statistics.shadowCasters ++;
+            if (shadowTests[i] == SHADOW_CULLED) {
+                statistics.culledShadowCasters ++;
+                continue;
+            }
+            if (shadowTests[i] == SHADOW_Z_FAIL) statistics.zFailShadowCasters ++;
+
+            vec4 bounds;
+            if (!projectShadowVolume(view.viewProjection, center, radius, light, bounds)) bounds = vec4(-1.f, -1.f, 1.f, 1.f);
+            screen = vec4(std::min(screen.x, bounds.x), std::min(screen.y, bounds.y), std::max(screen.z, bounds.z), std::max(screen.w, bounds.w));
+        }
+    }
+
+    // Stencil is only updated where some volume may be seen
+    const vec2 size(graph.getWidth(), graph.getHeight());
+    const vec2 low = clamp((vec2(screen.x, screen.y) * 0.5f + 0.5f) * size, vec2(0.f), size);
+    const vec2 high = clamp((vec2(screen.z, screen.w) * 0.5f + 0.5f) * size, vec2(0.f), size);
+    const ivec2 origin(floor(low));
+    const ivec2 extent(max(ceil(high) - floor(low), vec2(0.f)));
+    shadowScissor = ivec4(origin.x, origin.y, extent.x, extent.y);
+    statistics.shadowScissorCoverage = float(shadowScissor.z * shadowScissor.w) / (size.x * size.y);
+}
+
+void Renderer::fitShadowCascades()
+{
+    // Cascades cover the view up to where shadows stop being drawn, the
+    // nearer ones being smaller for more texels close to the camera
+    const CameraBlock& view = uniforms.getCamera();
+    const float near = view.projection[3][2] / (view.projection[2][2] - 1.f);
+    const float shadowDistance = 40.f;
+
+    float ends[maxShadowCascades];
+    splitShadowCascades(near, shadowDistance, shadowCascadeCount, 0.75f, ends);
+    for (unsigned int cascade = 0; cascade < shadowCascadeCount; cascade ++) {
+        const float begin = cascade ? ends[cascade - 1] : near;
+        shadowCascades[cascade] = fitShadowCascade(view.view, view.projection, begin, ends[cascade], vec3(directionalLight.direction), unsigned(shadowMapSize));
+    }
+}
+
+void Renderer::addMesh(unsigned int meshId)
+{
+    if (geometry.contains(meshId) || !meshStore.getById(meshId)) return;
+    Mesh& mesh = *meshStore.getById(meshId);
+    geometry.add(meshId, mesh);
+    materials.add(meshId, mesh);
+}
+
+void Renderer::reloadMesh(unsigned int meshId)
+{
+    geometry.remove(meshId);
+    shadowExtrusion.remove(meshId);
+}
+
+void Renderer::setShadowVolumeMode(ShadowVolumeMode mode)
+{
+    shadowVolumeMode = mode;
+    info("Renderer: shadow volumes extruded by the", mode == CPU ? "CPU" : "geometry shader");
+}
+
+Renderer::ShadowVolumeMode Renderer::getShadowVolumeMode() const
+{
+    return shadowVolumeMode;
+}
+
+void Renderer::setShadowTechnique(ShadowTechnique technique)
+{
+    shadowTechnique = technique;
+    shadowTimer.reset();
+    // Before setup the graph is built there
+    if (graph.getWidth() > 0) buildGraph();
+    info("Renderer: shadows found with", technique == SHADOW_MAPS ? "cascaded shadow maps" : "shadow volumes");
+}
+
+Renderer::ShadowTechnique Renderer::getShadowTechnique() const
+{
+    return shadowTechnique;
+}
+
+void Renderer::setShadowCascadeCount(unsigned int count)
+{
+    shadowCascadeCount = std::min(std::max(count, 2u), maxShadowCascades);
+    if (shadowTechnique == SHADOW_MAPS && graph.getWidth() > 0) buildGraph();
+}
+
+const RendererStatistics& Renderer::getStatistics() const
+{
+    return statistics;
+}
+
+bool Renderer::reloadTexture(const string& file)
+{
+    return materials.reload(file);
+}
+
+const vector<pair<unsigned int, float>>& Renderer::getWantedMeshes() const
+{
+    return wantedMeshes;
+}
+
+void Renderer::uploadMeshes(ThreadPool* pool)
+{
+    geometry.upload();
+    materials.upload(pool);
+
+    meshesMaterials.resize(meshStore.size(), 0);
+    for (unsigned int meshId = 0; meshId < meshesMaterials.size(); meshId ++) {
+        if (materials.contains(meshId)) meshesMaterials[meshId] = materials.getMaterial(meshId);
+    }
+}
+
+void Renderer::uploadInstances(const DrawList& drawList)
+{
+    const GLsizeiptr matrixSize = sizeof(GLfloat) * Transforms::matrixFloats;
+    const GLsizeiptr layerSize = sizeof(GLfloat);
+    const GLsizeiptr commandSize = sizeof(DrawElementsIndirectCommand);
+
+    // The matrices of the frame are composed in sorted order in one block of
+    // the ring, followed by the instances' material layers. Each batch reads
+    // its instances from its base instance
+    void* block;
+    instanceBuffer.begin((matrixSize + layerSize) * drawList.size() + matrixSize);
+    instancesOffset = instanceBuffer.allocate(matrixSize * drawList.size(), matrixSize, &block);
+    // The shadow extrusion reads the matrices back, not from write combined memory
+    instanceMatrices.resize(drawList.size() * Transforms::matrixFloats);
+    drawList.getTransforms().compose(instanceMatrices.data());
+    memcpy(block, instanceMatrices.data(), sizeof(GLfloat) * instanceMatrices.size());
+    layersOffset = instanceBuffer.allocate(layerSize * drawList.size(), layerSize, &block);
+    GLfloat* layers = static_cast<GLfloat*>(block);
+    for (auto& batch : drawList.getBatches()) {
+        fill(layers + batch.first, layers + batch.first + batch.count, materials.getLayer(batch.meshId));
+    }
+    instanceBuffer.end();
+
+    commands.clear();
+    adjacencyCommands.clear();
+    commandsSets.clear();
+
+    for (auto& batch : drawList.getBatches()) {
+        commands.push_back(geometry.getCommand(batch.meshId, batch.lod, batch.count, batch.first));
+        commandsSets.push_back(materials.getSet(batch.meshId));
+        statistics.triangles += commands.back().count / 3 * batch.count;
+
+        // The geometry shader extrudes the runs of moving z-pass casters of
+        // the batch, still ones draw their cached sides and z-fail ones their
+        // capped sides extruded on the CPU
+        if (shadowTechnique == SHADOW_MAPS || !batch.moving || shadowVolumeMode == CPU) continue;
+        for (unsigned int first = batch.first, last = first; first < batch.first + batch.count; first = last) {
+            while (first < batch.first + batch.count && shadowTests[first] != SHADOW_Z_PASS) first ++;
+            last = first;
+            while (last < batch.first + batch.count && shadowTests[last] == SHADOW_Z_PASS) last ++;
+            if (last > first) adjacencyCommands.push_back(geometry.getAdjacencyCommand(batch.meshId, batch.lod, last - first, first));
+        }
+    }
+
+    statistics.uploadedBytes += static_cast<unsigned long>(instanceBuffer.getAllocatedBytes());
+
+    // Shadow maps draw the casters with the instances' matrices
+    if (shadowTechnique == SHADOW_VOLUMES) {
+        for (auto& batch : drawList.getBatches()) {
+            shadowExtrusion.prepare(batch.meshId, batch.lod, *meshStore.getById(batch.meshId));
+            if (!batch.moving) shadowExtrusion.prepare(batch.meshId, ShadowExtrusion::stillLod, *meshStore.getById(batch.meshId));
+        }
+        shadowExtrusion.extrude(drawList, instanceMatrices.data(), shadowTests, vec3(directionalLight.direction), shadowVolumeMode == CPU);
+        statistics.uploadedBytes += static_cast<unsigned long>(shadowExtrusion.getAllocatedBytes());
+    }
+
+    // The fallback submits the commands from the CPU copies
+    if (!geometry.isMultiDrawIndirect()) return;
+
+    GLsizeiptr listSize = commandSize * GLsizeiptr(commands.size());
+    GLsizeiptr adjacencyListSize = commandSize * GLsizeiptr(adjacencyCommands.size());
+    indirectBuffer.begin(listSize + adjacencyListSize);
+    commandsOffset = indirectBuffer.allocate(listSize, commandSize, &block);
+    memcpy(block, commands.data(), size_t(listSize));
+    adjacencyCommandsOffset = indirectBuffer.allocate(adjacencyListSize, commandSize, &block);
+    memcpy(block, adjacencyCommands.data(), size_t(adjacencyListSize));
+    indirectBuffer.end();
 
-    glUniformMatrix4fv(program->getLocation("view"), 1, GL_FALSE, value_ptr(camera->getRotation() * camera->getTranslation()));
-    glUniformMatrix4fv(program->getLocation("projection"), 1, GL_FALSE, value_ptr(camera->getPerspective()));
+    statistics.uploadedBytes += static_cast<unsigned long>(indirectBuffer.getAllocatedBytes());
+}
 
-    for (unsigned int t = 0; t < models.size(); t ++) {
-        meshStore.getById(t)->draw(models.size(t));
+void Renderer::drawGeometry(GLenum mode, const vector<DrawElementsIndirectCommand>& list, GLintptr listOffset, unsigned int first, unsigned int count)
+{
+    if (geometry.isMultiDrawIndirect()) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer.getReference());
     }
+    geometry.bind(instanceBuffer.getReference(), instancesOffset, layersOffset);
+    geometry.draw(mode, list.data() + first, listOffset + GLintptr(sizeof(DrawElementsIndirectCommand) * first), count);
 
-    program->idle();
+    statistics.drawCalls += geometry.isMultiDrawIndirect() ? 1 : count;
 }
 
-void Renderer::shadowVolumePass(Aggregator<Model> &models)
+void Renderer::depthPass()
 {
-    unique_ptr<Program>& program = programStore.getById(params.shadowVolumeProgramId);
+    unique_ptr<Program>& program = programStore.getById(params.fillingProgramId);
     program->use();
 
-    glUniformMatrix4fv(program->getLocation("view"), 1, GL_FALSE, value_ptr(camera->getRotation() * camera->getTranslation()));
-    glUniformMatrix4fv(program->getLocation("projection"), 1, GL_FALSE, value_ptr(camera->getPerspective()));
-    glUniform4fv(program->getLocation("direct_light_direction"), 1, value_ptr(directionalLight.direction));
+    drawGeometry(GL_TRIANGLES, commands, commandsOffset, 0, unsigned(commands.size()));
+}
+
+void Renderer::shadowVolumePass()
+{
+    // Samples passed are read back once available, without waiting
+    GLuint samples = 0;
+    GLint available = 0;
+    if (shadowQueriesBegun >= shadowQueryCount) glGetQueryObjectiv(shadowQueries[shadowQuery], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available) {
+        glGetQueryObjectuiv(shadowQueries[shadowQuery], GL_QUERY_RESULT, &samples);
+        statistics.shadowSamples = samples;
+    }
+    glBeginQuery(GL_SAMPLES_PASSED, shadowQueries[shadowQuery]);
+    shadowQueriesBegun ++;
+    shadowTimer.begin();
+
+    glState().enable(GL_SCISSOR_TEST);
+    glState().scissor(shadowScissor.x, shadowScissor.y, shadowScissor.z, shadowScissor.w);
+
+    programStore.getById(params.shadowExtrusionProgramId)->use();
+    const ShadowExtrusion::Volumes zPassVolumes[] {ShadowExtrusion::STILL, ShadowExtrusion::MOVING};
+    for (auto volumes : zPassVolumes) {
+        if (shadowExtrusion.getVertexCount(volumes) == 0) continue;
+        shadowExtrusion.draw(volumes);
+        statistics.drawCalls ++;
+    }
 
-    for (unsigned int t = 0; t < models.size(); t ++) {
-        meshStore.getById(t)->drawAdjacency(models.size(t));
+    if (shadowVolumeMode == GEOMETRY_SHADER && !adjacencyCommands.empty()) {
+        programStore.getById(params.shadowVolumeProgramId)->use();
+        drawGeometry(GL_TRIANGLES_ADJACENCY, adjacencyCommands, adjacencyCommandsOffset, 0, unsigned(adjacencyCommands.size()));
     }
 
-    program->idle();
+    // Capped volumes count the faces behind the surfaces instead
+    if (shadowExtrusion.getVertexCount(ShadowExtrusion::Z_FAIL) > 0) {
+        programStore.getById(params.shadowExtrusionProgramId)->use();
+        glState().stencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+        glState().stencilOpSeparate(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+        shadowExtrusion.draw(ShadowExtrusion::Z_FAIL);
+        statistics.drawCalls ++;
+    }
+
+    glEndQuery(GL_SAMPLES_PASSED);
+    shadowQuery = (shadowQuery + 1) % shadowQueryCount;
 }
 
 void Renderer::shadowImprintPass()
@@ -146,28 +542,65 @@ void Renderer::shadowImprintPass()
     program->use();
 
     quad.draw();
-
-    program->idle();
+    shadowTimer.end();
 }
 
-void Renderer::geometryPass(Aggregator<Model> &models)
+void Renderer::shadowMapPass(unsigned int cascade)
 {
-    unique_ptr<Program>& program = programStore.getById(params.geometryBufferProgramId);
+    if (cascade == 0) shadowTimer.begin();
+
+    unique_ptr<Program>& program = programStore.getById(params.shadowMapProgramId);
     program->use();
+    program->set("light_view_projection", shadowCascades[cascade].viewProjection);
 
-    glUniform1i(program->getLocation("texture_diffuse"), 0);
-    glUniform1i(program->getLocation("texture_metallic"), 1);
-    glUniform1i(program->getLocation("texture_rough"), 2);
-    glUniform1i(program->getLocation("texture_normal"), 3);
-    glUniformMatrix4fv(program->getLocation("view"), 1, GL_FALSE, value_ptr(camera->getRotation() * camera->getTranslation()));
-    glUniformMatrix4fv(program->getLocation("projection"), 1, GL_FALSE, value_ptr(camera->getPerspective()));
+    drawGeometry(GL_TRIANGLES, commands, commandsOffset, 0, unsigned(commands.size()));
+}
 
-    for (unsigned int t = 0; t < models.size(); t ++) {
-        meshStore.getById(t)->bindTexture(GL_TEXTURE0, GL_TEXTURE1, GL_TEXTURE2, GL_TEXTURE3);
-        meshStore.getById(t)->draw(models.size(t));
+void Renderer::shadowMapImprintPass()
+{
+    unique_ptr<Program>& program = programStore.getById(params.shadowMapImprintProgramId);
+    program->use();
+
+    mat4 matrices[maxShadowCascades];
+    vec4 ends(0.f);
+    vec4 texels(0.f);
+    for (unsigned int cascade = 0; cascade < shadowCascadeCount; cascade ++) {
+        matrices[cascade] = shadowCascades[cascade].viewProjection;
+        ends[int(cascade)] = shadowCascades[cascade].end;
+        texels[int(cascade)] = shadowCascades[cascade].texelSize;
     }
 
-    program->idle();
+    program->set("depth", 0);
+    program->set("g_normal", 1);
+    program->set("shadow_map", 2);
+    program->set("inverse_view_projection", inverse(uniforms.getCamera().viewProjection));
+    program->set("cascade_matrices", matrices, GLsizei(shadowCascadeCount));
+    program->set("cascade_ends", ends);
+    program->set("cascade_texels", texels);
+    program->set("cascade_count", GLint(shadowCascadeCount));
+
+    quad.draw();
+    shadowTimer.end();
+}
+
+void Renderer::geometryPass()
+{
+    unique_ptr<Program>& program = programStore.getById(params.geometryBufferProgramId);
+    program->use();
+
+    program->set("texture_diffuse", 0);
+    program->set("texture_metallic", 1);
+    program->set("texture_rough", 2);
+    program->set("texture_normal", 3);
+
+    geometryTimer.begin();
+    // Commands are sorted by material, those of a material set are drawn with one bind
+    for (unsigned int first = 0, last = 0; first < commands.size(); first = last) {
+        while (last < commands.size() && commandsSets[last] == commandsSets[first]) last ++;
+        materials.bind(commandsSets[first], GL_TEXTURE0);
+        drawGeometry(GL_TRIANGLES, commands, commandsOffset, first, last - first);
+    }
+    geometryTimer.end();
 }
 
 void Renderer::lightingPass()
@@ -175,24 +608,32 @@ void Renderer::lightingPass()
     unique_ptr<Program>& program = programStore.getById(params.deferredShadingProgramId);
     program->use();
 
-    glUniform1i(program->getLocation("g_position"), 0);
-    glUniform1i(program->getLocation("g_normal"), 1);
-    glUniform1i(program->getLocation("g_diffuse"), 2);
-    glUniform1i(program->getLocation("g_mr"), 3);
-    glUniform1i(program->getLocation("g_shadow"), 4);
-    glUniform1i(program->getLocation("environment"), 5);
-    glUniform1i(program->getLocation("irradiance_map"), 6);
-    glUniform3fv(program->getLocation("ambiant_color"), 1, value_ptr(directionalLight.ambiant));
-    glUniform3fv(program->getLocation("direct_light_color"), 1, value_ptr(directionalLight.color));
-    glUniform3fv(program->getLocation("direct_light_direction"), 1, value_ptr(directionalLight.direction * -1.f));
-    glUniform3fv(program->getLocation("view_position"), 1, value_ptr(camera->getPosition()));
-    glUniform1f(program->getLocation("gamma"), 2.2);
-
-    gBuffer.bindTextures(GL_TEXTURE0, GL_TEXTURE1, GL_TEXTURE2, GL_TEXTURE3, GL_TEXTURE4);
+    program->set("g_depth", 0);
+    program->set("g_normal", 1);
+    program->set("g_diffuse", 2);
+    program->set("g_material", 3);
+    program->set("environment", 4);
+    program->set("irradiance_map", 5);
+    program->set("gamma", 2.2f);
+    program->set("inverse_view_projection", inverse(uniforms.getCamera().viewProjection));
+
+    cubemapStore.getById(params.cubemapId)->bind(GL_TEXTURE4);
     cubemapStore.getById(params.cubemapId)->bind(GL_TEXTURE5);
-    cubemapStore.getById(params.cubemapId)->bind(GL_TEXTURE6);
 
+    lightingTimer.begin();
     quad.draw();
+    lightingTimer.end();
+}
 
-    program->idle();
+void Renderer::reportStatistics()
+{
+    if (statistics.frames ++ % 600 != 0) return;
+    info("Renderer:", statistics.drawCalls, "draw calls,", statistics.uploadedBytes, "bytes uploaded per frame");
+    info("Renderer:", statistics.triangles, "triangles drawn per pass");
+    info("Renderer:", statistics.shadowCasters, "shadow casters,", statistics.culledShadowCasters, "culled,", statistics.zFailShadowCasters, "z-fail,",
+        statistics.shadowSamples, "samples passed in", int(statistics.shadowScissorCoverage * 100.f), "% of the screen");
+    info("Renderer:", statistics.shadowMilliseconds, "ms drawing the", shadowTechnique == SHADOW_MAPS ? "shadow maps," : "shadow volumes,",
+        statistics.geometryMilliseconds, "ms the geometry buffer,", statistics.lightingMilliseconds, "ms the lighting, on the GPU");
+    info("Renderer:", statistics.uniformCalls, "uniform calls,", statistics.elidedUniformCalls, "elided per frame");
+    info("Renderer:", statistics.stateCalls, "state changes,", statistics.redundantStateCalls, "redundant dropped per frame");
 }
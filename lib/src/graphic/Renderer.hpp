@@ -1,20 +1,30 @@
 #pragma once
 #include "Quad.hpp"
-#include "GBuffer.hpp"
 #include "DirectionalLight.hpp"
 #include "RendererParams.hpp"
+#include "RendererStatistics.hpp"
+#include "RenderGraph.hpp"
 #include "Cubemap.hpp"
 #include "Program.hpp"
 #include "Mesh.hpp"
+#include "GeometryArena.hpp"
+#include "GpuTimer.hpp"
+#include "ShadowExtrusion.hpp"
+#include "MaterialArrays.hpp"
+#include "StreamBuffer.hpp"
+#include "UniformBuffer.hpp"
+#include "../utils/ShadowCascades.hpp"
 #include <glm/glm.hpp>
+#include <string>
+#include <utility>
+#include <vector>
 
 template <typename T, typename TT, typename TTT>
 class Store;
-template <typename T>
-class Aggregator;
 class Camera;
-class Model;
 class Program;
+class DrawList;
+class ThreadPool;
 struct CubemapParams;
 struct ProgramParams;
 
@@ -23,6 +33,11 @@ class Renderer
 
 public:
 
+    // Where the sides of the shadow volumes are extruded
+    enum ShadowVolumeMode { GEOMETRY_SHADER, CPU };
+    // How the directional light's shadows are found
+    enum ShadowTechnique { SHADOW_VOLUMES, SHADOW_MAPS };
+
     Renderer(
         Store<const char*, Mesh, MeshParams>& meshStore,
         Store<const char*, Program, ProgramParams>& programStore,
@@ -30,26 +45,99 @@ public:
     );
     ~Renderer();
 
-    void render(Aggregator<Model>& models);
+    void render(DrawList& drawList);
     void setup(RendererParams params);
+    // Upload every stored mesh ahead of the first frame, loading on the pool's workers
+    void load(ThreadPool& pool);
+
+    // Drop the GPU copy of a mesh replaced in its store slot, the new one is uploaded when drawn
+    void reloadMesh(unsigned int meshId);
+    // Upload the textures made from file again, return whether any mesh uses it
+    bool reloadTexture(const std::string& file);
+
+    // Software GL implementations default to the CPU, geometry shaders are slow there
+    void setShadowVolumeMode(ShadowVolumeMode mode);
+    ShadowVolumeMode getShadowVolumeMode() const;
+
+    // Both write the shadow mask the lighting reads, switching rebuilds the render graph
+    void setShadowTechnique(ShadowTechnique technique);
+    ShadowTechnique getShadowTechnique() const;
+    // Shadow maps split the view in 2 to 4 cascades
+    void setShadowCascadeCount(unsigned int count);
+
+    // Counters of the last frame
+    const RendererStatistics& getStatistics() const;
+
+    // Meshes drawn last frame which are not loaded yet, with how much they are
+    // wanted: the distance to the camera, pushed back when out of view
+    const std::vector<std::pair<unsigned int, float>>& getWantedMeshes() const;
 
 private:
 
-    void uploadMatrices(Aggregator<Model> &models);
-    void depthPass(Aggregator<Model> &models);
-    void shadowVolumePass(Aggregator<Model> &models);
-    void geometryPass(Aggregator<Model> &models);
+    void buildGraph();
+    void loadMeshes(DrawList& drawList);
+    void addMesh(unsigned int meshId);
+    void selectLods(DrawList& drawList);
+    void classifyShadowCasters(const DrawList& drawList);
+    void fitShadowCascades();
+    void uploadMeshes(ThreadPool* pool);
+    void uploadInstances(const DrawList& drawList);
+    void drawGeometry(GLenum mode, const std::vector<DrawElementsIndirectCommand>& list, GLintptr listOffset, unsigned int first, unsigned int count);
+    void depthPass();
+    void shadowVolumePass();
+    void geometryPass();
     void lightingPass();
     void shadowImprintPass();
+    void shadowMapPass(unsigned int cascade);
+    void shadowMapImprintPass();
+    void reportStatistics();
 
     RendererParams params;
+    RendererStatistics statistics;
 
     Store<const char*, Mesh, MeshParams>& meshStore;
     Store<const char*, Program, ProgramParams>& programStore;
     Store<const char*, Cubemap, CubemapParams>& cubemapStore;
 
     Quad quad;
-    GBuffer gBuffer;
+    RenderGraph graph;
+    GeometryArena geometry;
+    MaterialArrays materials;
+    UniformBuffer uniforms;
+    StreamBuffer instanceBuffer;
+    StreamBuffer indirectBuffer;
+    ShadowExtrusion shadowExtrusion;
+    ShadowVolumeMode shadowVolumeMode = GEOMETRY_SHADER;
+    ShadowTechnique shadowTechnique = SHADOW_VOLUMES;
+
+    static const unsigned int maxShadowCascades = 4;
+    static const GLsizei shadowMapSize = 2048;
+    unsigned int shadowCascadeCount = 3;
+    ShadowCascade shadowCascades[maxShadowCascades];
+
+    // Draw commands of the frame, one per batch, and their offsets in indirectBuffer
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<DrawElementsIndirectCommand> adjacencyCommands;
+    std::vector<unsigned int> commandsSets;
+    std::vector<float> instanceMatrices;
+    std::vector<ShadowVolumeTest> shadowTests;
+    glm::ivec4 shadowScissor;
+    static const unsigned int shadowQueryCount = 3;
+    GLuint shadowQueries[shadowQueryCount] {};
+    unsigned int shadowQuery = 0;
+    unsigned int shadowQueriesBegun = 0;
+    GpuTimer shadowTimer;
+    GpuTimer geometryTimer;
+    GpuTimer lightingTimer;
+    std::vector<unsigned int> meshesMaterials;
+    std::vector<unsigned int> resolvedMeshes;
+    std::vector<float> meshesWants;
+    std::vector<std::pair<unsigned int, float>> wantedMeshes;
+    GLintptr instancesOffset = 0;
+    GLintptr layersOffset = 0;
+    GLintptr commandsOffset = 0;
+    GLintptr adjacencyCommandsOffset = 0;
+
     // This should be passed as arguments to the render method (light store?)
     DirectionalLight directionalLight; // Could be entity component
     Camera *camera; // Could be entity component
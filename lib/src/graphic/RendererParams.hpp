@@ -1,12 +1,19 @@
 #pragma once
+#include <OpenGL.hpp>
 
 // TODO use File instead of const char*
 struct RendererParams
 {
     unsigned int cubemapId;
     unsigned int shadowVolumeProgramId;
+    unsigned int shadowExtrusionProgramId; // Draws the sides extruded on the CPU
     unsigned int shadowImprintProgramId;
+    unsigned int shadowMapProgramId;
+    unsigned int shadowMapImprintProgramId;
     unsigned int fillingProgramId;
     unsigned int geometryBufferProgramId;
     unsigned int deferredShadingProgramId;
+    unsigned int placeholderMeshId; // Drawn instead of the meshes still loading
+    GLsizei width;  // Of the default framebuffer
+    GLsizei height;
 };
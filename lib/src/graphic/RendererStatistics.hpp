@@ -0,0 +1,37 @@
+#pragma once
+
+// Counters gathered by the renderer during a frame
+struct RendererStatistics
+{
+    unsigned int frames = 0;
+    unsigned long uploadedBytes = 0;
+    unsigned int drawCalls = 0;
+    unsigned long triangles = 0;
+    unsigned int uniformCalls = 0;
+    unsigned int elidedUniformCalls = 0;
+    unsigned int stateCalls = 0;
+    unsigned int redundantStateCalls = 0;
+    unsigned int shadowCasters = 0;
+    unsigned int culledShadowCasters = 0;
+    unsigned int zFailShadowCasters = 0;
+    float shadowScissorCoverage = 0.f; // Part of the screen the shadow volumes are rasterized in
+    unsigned long shadowSamples = 0; // Read back a few frames late
+    // GPU time of the passes, read back a few frames late
+    float shadowMilliseconds = 0.f;
+    float geometryMilliseconds = 0.f;
+    float lightingMilliseconds = 0.f;
+
+    void reset()
+    {
+        uploadedBytes = 0;
+        drawCalls = 0;
+        triangles = 0;
+        uniformCalls = 0;
+        elidedUniformCalls = 0;
+        stateCalls = 0;
+        redundantStateCalls = 0;
+        shadowCasters = 0;
+        culledShadowCasters = 0;
+        zFailShadowCasters = 0;
+    }
+};
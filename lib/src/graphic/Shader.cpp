@@ -10,7 +10,7 @@ Shader::Shader(GLuint _type, GLuint _programReference)
 {
 }
 
-void Shader::load(const char* filename)
+bool Shader::load(const char* filename)
 {
     // Read
     ifstream file(filename, ifstream::in);
@@ -35,10 +35,12 @@ void Shader::load(const char* filename)
         } else {
             glAttachShader(programReference, reference);
             success("Shader loaded:", filename);
+            return true;
         }
     } else {
         error("Cannot open", filename);
     }
+    return false;
 }
 
 Shader::~Shader()
@@ -9,7 +9,8 @@ public:
     Shader(GLuint _type, GLuint _programReference);
     ~Shader();
 
-    void load(const char* filename);
+    // Return false when the file can't be read or compiled
+    bool load(const char* filename);
 
 private:
 
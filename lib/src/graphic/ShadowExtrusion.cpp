@@ -0,0 +1,218 @@
+#include "ShadowExtrusion.hpp"
+#include "DrawList.hpp"
+#include "GeometryArena.hpp"
+#include "GLState.hpp"
+#include "Mesh.hpp"
+#include "../utils/ThreadPool.hpp"
+#include "../utils/Transforms.hpp"
+#include <algorithm>
+#include <string.h>
+
+using namespace std;
+using namespace glm;
+
+const unsigned int ShadowExtrusion::stillLod;
+
+namespace
+{
+    const unsigned int lods = GeometryArena::maxLods;
+    const unsigned int none = ~0u;
+}
+
+ShadowExtrusion::ShadowExtrusion()
+    : vertexBuffer(GL_ARRAY_BUFFER, 1 << 20)
+{
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &stillBuffer);
+    glState().bindVertexArray(VAO);
+    glEnableVertexAttribArray(0);
+}
+
+ShadowExtrusion::~ShadowExtrusion()
+{
+    glState().deleteVertexArray(VAO);
+    glDeleteBuffers(1, &stillBuffer);
+}
+
+void ShadowExtrusion::remove(unsigned int meshId)
+{
+    for (unsigned int lod = 0; lod < lods; lod ++) {
+        if (meshId * lods + lod < casters.size()) casters[meshId * lods + lod].reset();
+    }
+    cachedStillKey.clear();
+}
+
+void ShadowExtrusion::prepare(unsigned int meshId, unsigned int lod, const Mesh& mesh)
+{
+    const unsigned int index = meshId * lods + lod;
+    if (casters.size() <= index) casters.resize(index + 1);
+    if (casters[index]) return;
+
+    casters[index].reset(new ShadowCaster());
+    prepareShadowCaster(mesh.getVertexes(), mesh.getAdjacencyIndexes(std::min(lod, mesh.getLodCount() - 1)), *casters[index]);
+}
+
+const ShadowCaster* ShadowExtrusion::getCaster(unsigned int meshId, unsigned int lod) const
+{
+    const unsigned int index = meshId * lods + lod;
+    return index < casters.size() ? casters[index].get() : nullptr;
+}
+
+void ShadowExtrusion::extrude(const DrawList& drawList, const float* matrices, const vector<ShadowVolumeTest>& tests, const vec3& lightDirection, bool streamMoving)
+{
+    const vector<DrawList::Batch>& batches = drawList.getBatches();
+    const vector<unsigned int>& order = drawList.getOrder();
+    const vector<unsigned int>& meshes = drawList.getMeshes();
+
+    // Still instances are walked in the order they were added, which the
+    // camera doesn't change, unlike the sorted order
+    stillInstances.assign(drawList.size(), none);
+    for (auto& batch : batches) {
+        if (batch.moving) continue;
+        for (unsigned int i = batch.first; i < batch.first + batch.count; i ++) {
+            stillInstances[order[i]] = i;
+        }
+    }
+
+    instances.clear();
+    stillKey.assign(reinterpret_cast<const uint32_t*>(&lightDirection), reinterpret_cast<const uint32_t*>(&lightDirection) + 3);
+    for (unsigned int added = 0; added < stillInstances.size(); added ++) {
+        const unsigned int i = stillInstances[added];
+        if (i == none) continue;
+        const uint32_t* matrix = reinterpret_cast<const uint32_t*>(matrices + i * Transforms::matrixFloats);
+        instances.push_back({getCaster(meshes[added], stillLod), matrices + i * Transforms::matrixFloats});
+        stillKey.push_back(meshes[added]);
+        stillKey.insert(stillKey.end(), matrix, matrix + Transforms::matrixFloats);
+    }
+
+    if (stillKey != cachedStillKey) {
+        cachedStillKey.swap(stillKey);
+        stillSizes.resize(instances.size());
+        stillFirsts.resize(instances.size());
+        const size_t count = extrudeChunks(instances, lightDirection, false, chunks, stillSizes.data());
+        GLint first = 0;
+        for (unsigned int s = 0; s < stillSizes.size(); s ++) {
+            stillFirsts[s] = first;
+            first += stillSizes[s];
+        }
+        vector<char> vertexes(sizeof(vec4) * count);
+        copyChunks(chunks, vertexes.data());
+        glBindBuffer(GL_ARRAY_BUFFER, stillBuffer);
+        glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(vertexes.size()), vertexes.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // Only the cached sides of the z-pass instances are drawn, consecutive ones together
+    runFirsts.clear();
+    runSizes.clear();
+    counts[STILL] = 0;
+    for (unsigned int added = 0, s = 0; added < stillInstances.size(); added ++) {
+        const unsigned int i = stillInstances[added];
+        if (i == none) continue;
+        const GLint first = stillFirsts[s];
+        const GLsizei size = stillSizes[s ++];
+        if (tests[i] != SHADOW_Z_PASS || size == 0) continue;
+        if (!runFirsts.empty() && runFirsts.back() + runSizes.back() == first) {
+            runSizes.back() += size;
+        } else {
+            runFirsts.push_back(first);
+            runSizes.push_back(size);
+        }
+        counts[STILL] += unsigned(size);
+    }
+
+    // Moving instances in the view, then every capped volume
+    instances.clear();
+    for (auto& batch : batches) {
+        if (!batch.moving || !streamMoving) continue;
+        for (unsigned int i = batch.first; i < batch.first + batch.count; i ++) {
+            if (tests[i] == SHADOW_Z_PASS) instances.push_back({getCaster(batch.meshId, batch.lod), matrices + i * Transforms::matrixFloats});
+        }
+    }
+    counts[MOVING] = unsigned(extrudeChunks(instances, lightDirection, false, chunks));
+
+    instances.clear();
+    for (auto& batch : batches) {
+        for (unsigned int i = batch.first; i < batch.first + batch.count; i ++) {
+            if (tests[i] == SHADOW_Z_FAIL) instances.push_back({getCaster(batch.meshId, batch.lod), matrices + i * Transforms::matrixFloats});
+        }
+    }
+    counts[Z_FAIL] = unsigned(extrudeChunks(instances, lightDirection, true, zFailChunks));
+
+    void* block;
+    const GLsizeiptr movingSize = GLsizeiptr(sizeof(vec4) * counts[MOVING]);
+    const GLsizeiptr zFailSize = GLsizeiptr(sizeof(vec4) * counts[Z_FAIL]);
+    vertexBuffer.begin(movingSize + zFailSize);
+    offsets[MOVING] = vertexBuffer.allocate(movingSize, sizeof(vec4), &block);
+    copyChunks(chunks, static_cast<char*>(block));
+    offsets[Z_FAIL] = vertexBuffer.allocate(zFailSize, sizeof(vec4), &block);
+    copyChunks(zFailChunks, static_cast<char*>(block));
+    vertexBuffer.end();
+}
+
+size_t ShadowExtrusion::extrudeChunks(const vector<Instance>& instances, const vec3& lightDirection, bool caps, Chunks& chunks, GLsizei* sizes)
+{
+    // A few chunks per thread so uneven meshes still spread, written in order.
+    // They come before the meshes streamed in the background
+    const unsigned int count = unsigned(instances.size());
+    const unsigned int chunkCount = std::min(count, (threadPool().size() + 1) * 4);
+    ThreadPool::Group group;
+    chunks.resize(chunkCount);
+    for (unsigned int c = 0; c < chunkCount; c ++) {
+        const unsigned int begin = count * c / chunkCount;
+        const unsigned int end = count * (c + 1) / chunkCount;
+        threadPool().enqueue([&instances, &chunks, lightDirection, caps, sizes, begin, end, c]() {
+            chunks[c].clear();
+            for (unsigned int i = begin; i < end; i ++) {
+                const size_t before = chunks[c].size();
+                if (instances[i].caster) extrudeSilhouette(*instances[i].caster, instances[i].matrix, lightDirection, chunks[c], caps);
+                if (sizes) sizes[i] = GLsizei(chunks[c].size() - before);
+            }
+        }, ThreadPool::URGENT, &group);
+    }
+    threadPool().wait(group);
+
+    size_t total = 0;
+    for (auto& chunk : chunks) {
+        total += chunk.size();
+    }
+    return total;
+}
+
+void ShadowExtrusion::copyChunks(const Chunks& chunks, char* out)
+{
+    for (auto& chunk : chunks) {
+        memcpy(out, chunk.data(), sizeof(vec4) * chunk.size());
+        out += sizeof(vec4) * chunk.size();
+    }
+}
+
+void ShadowExtrusion::draw(Volumes volumes)
+{
+    if (counts[volumes] == 0) return;
+
+    // The ring can be reallocated when it grows, it is pointed every frame
+    glState().bindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, volumes == STILL ? stillBuffer : vertexBuffer.getReference());
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<const GLvoid *>(offsets[volumes]));
+    if (volumes == STILL) {
+        glMultiDrawArrays(GL_TRIANGLES, runFirsts.data(), runSizes.data(), GLsizei(runFirsts.size()));
+    } else {
+        glDrawArrays(GL_TRIANGLES, 0, GLsizei(counts[volumes]));
+    }
+}
+
+void ShadowExtrusion::fence()
+{
+    vertexBuffer.fence();
+}
+
+unsigned int ShadowExtrusion::getVertexCount(Volumes volumes) const
+{
+    return counts[volumes];
+}
+
+GLsizeiptr ShadowExtrusion::getAllocatedBytes() const
+{
+    return vertexBuffer.getAllocatedBytes();
+}
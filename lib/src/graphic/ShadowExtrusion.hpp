@@ -0,0 +1,96 @@
+#pragma once
+#include "StreamBuffer.hpp"
+#include "../utils/ShadowCulling.hpp"
+#include "../utils/SilhouetteExtruder.hpp"
+#include <OpenGL.hpp>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class DrawList;
+class Mesh;
+
+// Shadow volume sides extruded on the CPU instead of by the geometry shader,
+// which software GL implementations (llvmpipe) run very slowly. Instances are
+// split among worker threads and their sides streamed in one vertex buffer.
+// The sides of the still instances are kept in a static buffer and drawn
+// again until they, or the light, change. They are extruded from a fixed level
+// of detail in the order the instances were added, so the camera moving
+// doesn't invalidate them.
+class ShadowExtrusion
+{
+
+public:
+
+    // Sides drawn together, the z-fail ones are capped
+    enum Volumes { STILL, MOVING, Z_FAIL };
+
+    // Level of detail the still instances' sides are extruded from
+    static const unsigned int stillLod = 0;
+
+    ShadowExtrusion();
+    ~ShadowExtrusion();
+
+    // Forget the caster of a mesh replaced in its store slot
+    void remove(unsigned int meshId);
+    // Caster of a mesh's level of detail, built on first use
+    void prepare(unsigned int meshId, unsigned int lod, const Mesh& mesh);
+
+    // Extrude the sorted instances of drawList, whose matrices are composed in
+    // matrices, away from the light, as tests tells. Their meshes must be
+    // prepared, at stillLod too for the still ones. Still instances are only
+    // extruded when they differ from the cached ones, whatever their test, and
+    // only the z-pass ones are drawn. Moving ones are extruded when
+    // streamMoving is set
+    void extrude(const DrawList& drawList, const float* matrices, const std::vector<ShadowVolumeTest>& tests, const glm::vec3& lightDirection, bool streamMoving);
+    // Draw the sides as triangles with the bound program
+    void draw(Volumes volumes);
+    void fence();
+
+    unsigned int getVertexCount(Volumes volumes) const;
+    GLsizeiptr getAllocatedBytes() const;
+
+private:
+
+    typedef std::vector<std::vector<glm::vec4>> Chunks;
+
+    struct Instance
+    {
+        const ShadowCaster* caster;
+        const float* matrix;
+    };
+
+    const ShadowCaster* getCaster(unsigned int meshId, unsigned int lod) const;
+    // Extrude the instances having a caster into chunks, return the vertex
+    // count. Each instance's count is written in sizes when given
+    size_t extrudeChunks(const std::vector<Instance>& instances, const glm::vec3& lightDirection, bool caps, Chunks& chunks, GLsizei* sizes = nullptr);
+    static void copyChunks(const Chunks& chunks, char* out);
+
+    StreamBuffer vertexBuffer;
+    GLuint VAO = 0;
+
+    // What the cached sides were extruded from: the light, then the mesh and
+    // matrix bits of each still instance, in the order they were added
+    std::vector<uint32_t> stillKey;
+    std::vector<uint32_t> cachedStillKey;
+    GLuint stillBuffer = 0;
+    // Sorted index of each instance added still, then where the cached sides
+    // of each start in stillBuffer and their vertex counts
+    std::vector<unsigned int> stillInstances;
+    std::vector<GLint> stillFirsts;
+    std::vector<GLsizei> stillSizes;
+    // Runs of cached sides drawn this frame
+    std::vector<GLint> runFirsts;
+    std::vector<GLsizei> runSizes;
+
+    // Offsets in vertexBuffer, or stillBuffer, and counts of each volumes
+    GLintptr offsets[3] {};
+    unsigned int counts[3] {};
+
+    // Indexed by mesh id * lods + lod
+    std::vector<std::unique_ptr<ShadowCaster>> casters;
+    std::vector<Instance> instances;
+    Chunks chunks;
+    Chunks zFailChunks;
+};
@@ -0,0 +1,127 @@
+#include "StreamBuffer.hpp"
+#include "../utils/Log.hpp"
+#include <assert.h>
+
+const unsigned int StreamBuffer::regions;
+
+StreamBuffer::StreamBuffer(GLenum _target, GLsizeiptr _regionSize)
+    : target(_target)
+    , regionSize(_regionSize)
+    , persistent(GLAD_GL_ARB_buffer_storage != 0)
+{
+    create();
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    destroy();
+}
+
+void StreamBuffer::begin(GLsizeiptr frameSize)
+{
+    region = (region + 1) % regions;
+    allocatedBytes = 0;
+    mappedSize = frameSize;
+
+    if (frameSize > regionSize) {
+        // Only happens while the scene grows, the ring is never shrunk
+        destroy();
+        while (regionSize < frameSize) regionSize *= 2;
+        create();
+        info("StreamBuffer: grown to", regions, "x", regionSize, "bytes");
+    }
+
+    wait(region);
+
+    if (persistent) {
+        regionMapping = mapping + region * regionSize;
+    } else if (frameSize > 0) {
+        glBindBuffer(target, reference);
+        regionMapping = static_cast<char*>(glMapBufferRange(target, region * regionSize, frameSize, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+    } else {
+        regionMapping = nullptr;
+    }
+}
+
+GLintptr StreamBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment, void** pointer)
+{
+    allocatedBytes = (allocatedBytes + alignment - 1) / alignment * alignment;
+    assert(allocatedBytes + size <= mappedSize && "StreamBuffer: frame size exceeded");
+
+    *pointer = regionMapping + allocatedBytes;
+    GLintptr offset = region * regionSize + allocatedBytes;
+    allocatedBytes += size;
+    return offset;
+}
+
+void StreamBuffer::end()
+{
+    if (!persistent && regionMapping) {
+        glBindBuffer(target, reference);
+        glUnmapBuffer(target);
+    }
+    regionMapping = nullptr;
+}
+
+void StreamBuffer::fence()
+{
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLuint StreamBuffer::getReference() const
+{
+    return reference;
+}
+
+GLsizeiptr StreamBuffer::getAllocatedBytes() const
+{
+    return allocatedBytes;
+}
+
+bool StreamBuffer::isPersistent() const
+{
+    return persistent;
+}
+
+void StreamBuffer::create()
+{
+    glGenBuffers(1, &reference);
+    glBindBuffer(target, reference);
+
+    if (persistent) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(target, regionSize * regions, NULL, flags);
+        mapping = static_cast<char*>(glMapBufferRange(target, 0, regionSize * regions, flags));
+    } else {
+        glBufferData(target, regionSize * regions, NULL, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(target, 0);
+}
+
+void StreamBuffer::destroy()
+{
+    for (unsigned int i = 0; i < regions; i ++) {
+        wait(i);
+    }
+    if (persistent && mapping) {
+        glBindBuffer(target, reference);
+        glUnmapBuffer(target);
+        glBindBuffer(target, 0);
+        mapping = nullptr;
+    }
+    glDeleteBuffers(1, &reference);
+}
+
+void StreamBuffer::wait(unsigned int index)
+{
+    if (!fences[index]) return;
+
+    GLenum status = glClientWaitSync(fences[index], 0, 0);
+    while (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED && status != GL_WAIT_FAILED) {
+        status = glClientWaitSync(fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    }
+
+    glDeleteSync(fences[index]);
+    fences[index] = 0;
+}
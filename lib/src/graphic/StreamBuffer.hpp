@@ -0,0 +1,47 @@
+#pragma once
+#include <OpenGL.hpp>
+
+// Ring of GPU memory rewritten by the CPU every frame. It is split in one
+// region per frame in flight, each guarded by a fence, so writing a frame never
+// waits on the driver unless the GPU is still reading that region.
+class StreamBuffer
+{
+
+public:
+
+    StreamBuffer(GLenum target, GLsizeiptr regionSize);
+    ~StreamBuffer();
+
+    // Wait for the next region to be released by the GPU and map frameSize bytes of it
+    void begin(GLsizeiptr frameSize);
+    // Reserve size bytes of the mapped region, return their offset in the buffer
+    GLintptr allocate(GLsizeiptr size, GLsizeiptr alignment, void** pointer);
+    // Make the written bytes visible to the GPU
+    void end();
+    // Guard the region once the draw calls reading it have been issued
+    void fence();
+
+    GLuint getReference() const;
+    GLsizeiptr getAllocatedBytes() const;
+    bool isPersistent() const;
+
+private:
+
+    void create();
+    void destroy();
+    void wait(unsigned int index);
+
+    GLenum target;
+    GLuint reference = 0;
+    GLsizeiptr regionSize;
+    unsigned int region = 0;
+
+    bool persistent;
+    char* mapping = nullptr;
+    char* regionMapping = nullptr;
+    GLsizeiptr mappedSize = 0;
+    GLsizeiptr allocatedBytes = 0;
+
+    static const unsigned int regions = 3;
+    GLsync fences[regions] {};
+};
@@ -0,0 +1,85 @@
+#include "UniformBuffer.hpp"
+#include "Camera.hpp"
+#include "DirectionalLight.hpp"
+#include <string.h>
+
+using namespace std;
+using namespace glm;
+
+namespace
+{
+    void bindBlock(GLuint program, const char* name, GLuint binding)
+    {
+        GLuint index = glGetUniformBlockIndex(program, name);
+        if (index != GL_INVALID_INDEX) glUniformBlockBinding(program, index, binding);
+    }
+
+    // Planes of the frustum (left, right, bottom, top, near, far) in world space
+    void extractFrustumPlanes(const mat4& m, vec4 planes[6])
+    {
+        for (int i = 0; i < 3; i ++) {
+            vec4 row(m[0][i], m[1][i], m[2][i], m[3][i]);
+            vec4 w(m[0][3], m[1][3], m[2][3], m[3][3]);
+            planes[i * 2 + 0] = w + row;
+            planes[i * 2 + 1] = w - row;
+        }
+        for (int i = 0; i < 6; i ++) {
+            // The far plane of an infinite projection is degenerate
+            float length = glm::length(vec3(planes[i]));
+            if (length > 0.f) planes[i] /= length;
+        }
+    }
+}
+
+UniformBuffer::UniformBuffer()
+{
+    GLint alignment;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    lightOffset = (GLintptr(sizeof(CameraBlock)) + alignment - 1) / alignment * alignment;
+    data.resize(size_t(lightOffset) + sizeof(LightBlock));
+
+    glGenBuffers(1, &reference);
+    glBindBuffer(GL_UNIFORM_BUFFER, reference);
+    glBufferData(GL_UNIFORM_BUFFER, GLsizeiptr(data.size()), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferRange(GL_UNIFORM_BUFFER, CAMERA_BLOCK, reference, 0, sizeof(CameraBlock));
+    glBindBufferRange(GL_UNIFORM_BUFFER, LIGHT_BLOCK, reference, lightOffset, sizeof(LightBlock));
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    glDeleteBuffers(1, &reference);
+}
+
+void UniformBuffer::update(const Camera& camera, const DirectionalLight& light)
+{
+    cameraBlock.view = camera.getRotation() * camera.getTranslation();
+    cameraBlock.projection = camera.getPerspective();
+    cameraBlock.viewProjection = cameraBlock.projection * cameraBlock.view;
+    cameraBlock.position = vec4(camera.getPosition(), 1.f);
+    extractFrustumPlanes(cameraBlock.viewProjection, cameraBlock.frustumPlanes);
+
+    LightBlock lightBlock;
+    lightBlock.direction = light.direction;
+    lightBlock.color = vec4(light.color, 1.f);
+    lightBlock.ambiant = vec4(light.ambiant, 1.f);
+
+    memcpy(data.data(), &cameraBlock, sizeof(cameraBlock));
+    memcpy(data.data() + lightOffset, &lightBlock, sizeof(lightBlock));
+
+    glBindBuffer(GL_UNIFORM_BUFFER, reference);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, GLsizeiptr(data.size()), data.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+const CameraBlock& UniformBuffer::getCamera() const
+{
+    return cameraBlock;
+}
+
+void UniformBuffer::bindBlocks(GLuint program)
+{
+    bindBlock(program, "Camera", CAMERA_BLOCK);
+    bindBlock(program, "Light", LIGHT_BLOCK);
+}
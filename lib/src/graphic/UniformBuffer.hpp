@@ -0,0 +1,53 @@
+#pragma once
+#include <OpenGL.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Binding points of the uniform blocks shared by every shader
+#define CAMERA_BLOCK 0
+#define LIGHT_BLOCK 1
+
+class Camera;
+struct DirectionalLight;
+
+// std140 layout of the "Camera" block
+struct CameraBlock
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec4 position;
+    glm::vec4 frustumPlanes[6];
+};
+
+// std140 layout of the "Light" block
+struct LightBlock
+{
+    glm::vec4 direction;
+    glm::vec4 color;
+    glm::vec4 ambiant;
+};
+
+// Per frame data read by every pass, uploaded once per frame into a single buffer
+class UniformBuffer
+{
+
+public:
+
+    UniformBuffer();
+    ~UniformBuffer();
+
+    void update(const Camera& camera, const DirectionalLight& light);
+    // Camera data of the last update
+    const CameraBlock& getCamera() const;
+
+    // Attach the program's uniform blocks to their binding points
+    static void bindBlocks(GLuint program);
+
+private:
+
+    GLuint reference;
+    GLintptr lightOffset;
+    CameraBlock cameraBlock;
+    std::vector<char> data;
+};
@@ -2,12 +2,9 @@
 #include "../ecs/ComponentManager.hpp"
 #include "../ecs/Id.hpp"
 #include "../graphic/Renderer.hpp"
-#include "../utils/Aggregator.hpp"
-#include "../graphic/Model.hpp"
 #include "../utils/Log.hpp"
 
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtx/rotate_vector.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <glm/glm.hpp>
 #include <math.h>
 
@@ -15,6 +12,16 @@ using namespace std;
 using namespace glm;
 using namespace ecs;
 
+namespace
+{
+    // Same rotation as glm::orientation(direction, up) expressed as a quaternion
+    quat orientation(const vec3& direction, const vec3& up)
+    {
+        if (direction == up) return quat(1.f, 0.f, 0.f, 0.f);
+        return angleAxis(acos(dot(direction, up)), normalize(cross(up, direction)));
+    }
+}
+
 RenderSystem::RenderSystem(
     ComponentManager<Visibility>* vc,
     ComponentManager<Movement>* mc
@@ -27,7 +34,7 @@ RenderSystem::RenderSystem(
 
 void RenderSystem::update(Renderer& renderer)
 {
-    Aggregator<Model> models;
+    drawList.clear();
 
     for (unsigned int i = 0; i < getEntities()->size(); i ++) {
         id entity = getEntities()->at(i);
@@ -35,21 +42,22 @@ void RenderSystem::update(Renderer& renderer)
         if (visibilityComponents->hasComponent(entity)) {
             Visibility* visibility = visibilityComponents->getComponent(entity);
 
-            mat4 modelRotation;
-            mat4 modelTranslation;
-            mat4 modelScale = scale(mat4(1.0f), visibility->scale);
+            vec3 position(0.f, 0.f, 0.f);
+            quat rotation(1.f, 0.f, 0.f, 0.f);
+            bool moving = false;
 
             if (movementComponents->hasComponent(entity)) {
                 Movement* movement = movementComponents->getComponent(entity);
 
-                modelTranslation = translate(mat4(1.0f), movement->position);
-                modelRotation = orientation(movement->direction, vec3(-1.0f, 0.0f, 0.0f));
-                modelRotation = rotate(modelRotation, movement->spin, vec3(0.0f, 0.0f, 1.0f));
+                position = movement->position;
+                rotation = orientation(movement->direction, vec3(-1.0f, 0.0f, 0.0f));
+                rotation = rotation * angleAxis(movement->spin, vec3(0.0f, 0.0f, 1.0f));
+                moving = movement->velocity != 0.f || movement->spinSpeed != 0.f;
             }
 
-            models.add(visibility->meshId, Model(modelTranslation, modelRotation, modelScale));
+            drawList.add(visibility->meshId, position, rotation, visibility->scale, moving);
         }
     }
 
-    renderer.render(models);
+    renderer.render(drawList);
 }
@@ -2,10 +2,11 @@
 #include <ecs/System.hpp>
 #include <components/Visibility.hpp>
 #include <components/Movement.hpp>
+#include <graphic/DrawList.hpp>
 #include <glm/glm.hpp>
+#include <vector>
 
 class Renderer;
-template <typename T> class Aggregator;
 namespace ecs {
 template <typename T> class ComponentManager;
 }
@@ -26,4 +27,7 @@ private:
 
     ecs::ComponentManager<Visibility>* visibilityComponents;
     ecs::ComponentManager<Movement>* movementComponents;
+
+    // Kept between frames to reuse its capacity
+    DrawList drawList;
 };
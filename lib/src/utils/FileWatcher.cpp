@@ -0,0 +1,119 @@
+#include "FileWatcher.hpp"
+#include "Log.hpp"
+
+#ifdef __linux__
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher(const string& directory, unsigned int debounceMilliseconds)
+    : descriptor(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+    , debounce(debounceMilliseconds)
+{
+    if (descriptor == -1) {
+        error("FileWatcher: inotify unavailable, not watching", directory);
+        return;
+    }
+    watch(directory);
+}
+
+FileWatcher::~FileWatcher()
+{
+    if (descriptor != -1) close(descriptor);
+}
+
+vector<string> FileWatcher::poll()
+{
+    read();
+
+    vector<string> settled;
+    const auto now = chrono::steady_clock::now();
+    for (auto change = changes.begin(); change != changes.end();) {
+        if (now - change->second >= debounce) {
+            settled.push_back(change->first);
+            change = changes.erase(change);
+        } else {
+            change ++;
+        }
+    }
+    return settled;
+}
+
+void FileWatcher::watch(const string& directory)
+{
+    // inotify doesn't watch subdirectories, each one gets its own watch
+    const int id = inotify_add_watch(descriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (id == -1) {
+        warning("FileWatcher: cannot watch", directory);
+        return;
+    }
+    directories[id] = directory;
+
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) return;
+    while (dirent* entry = readdir(dir)) {
+        const string name(entry->d_name);
+        if (entry->d_type == DT_DIR && name != "." && name != "..") {
+            watch(directory + "/" + name);
+        }
+    }
+    closedir(dir);
+}
+
+void FileWatcher::read()
+{
+    if (descriptor == -1) return;
+
+    alignas(inotify_event) char buffer[4096];
+    for (;;) {
+        const ssize_t length = ::read(descriptor, buffer, sizeof(buffer));
+        if (length <= 0) return;
+
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += ssize_t(sizeof(inotify_event) + event->len);
+
+            auto directory = directories.find(event->wd);
+            if (directory == directories.end() || event->len == 0) continue;
+
+            const string path = directory->second + "/" + event->name;
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & IN_CREATE) watch(path);
+            } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                changes[path] = chrono::steady_clock::now();
+            }
+        }
+    }
+}
+
+#else
+
+FileWatcher::FileWatcher(const string& directory, unsigned int debounceMilliseconds)
+    : debounce(debounceMilliseconds)
+{
+    warning("FileWatcher: not supported on this platform, not watching", directory);
+}
+
+FileWatcher::~FileWatcher()
+{
+}
+
+vector<string> FileWatcher::poll()
+{
+    return vector<string>();
+}
+
+void FileWatcher::watch(const string&)
+{
+}
+
+void FileWatcher::read()
+{
+}
+
+#endif
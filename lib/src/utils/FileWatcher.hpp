@@ -0,0 +1,31 @@
+#pragma once
+#include <chrono>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Reports the files written under a directory and its subdirectories. A file
+// is reported once it stayed untouched for the debounce delay, editors often
+// write a file in several steps. Only implemented with Linux's inotify.
+class FileWatcher
+{
+
+public:
+
+    FileWatcher(const std::string& directory, unsigned int debounceMilliseconds = 200);
+    ~FileWatcher();
+
+    // Files changed since the last call which have settled, never blocks
+    std::vector<std::string> poll();
+
+private:
+
+    void watch(const std::string& directory);
+    void read();
+
+    int descriptor = -1;
+    std::chrono::milliseconds debounce;
+    std::unordered_map<int, std::string> directories;
+    std::map<std::string, std::chrono::steady_clock::time_point> changes;
+};
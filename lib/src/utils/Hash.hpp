@@ -0,0 +1,9 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 64 bits FNV-1a, fast and good enough to tell file contents apart.
+// Hashing in several parts gives the same hash when seeding each part with the previous hash
+const uint64_t fnv1aSeed = 14695981039346656037ull;
+
+uint64_t fnv1a(const void* data, size_t size, uint64_t seed = fnv1aSeed);
@@ -1,46 +1,136 @@
 #include "Manifold.hpp"
+#include "ThreadPool.hpp"
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
 
 using namespace std;
 
-void generateTrianglesAdjacencyIndex(std::vector<glm::uvec3> &triangles, std::vector<unsigned int> &indexes)
+namespace
 {
-    // Indexes' triangles
-    vector<vector<glm::uvec3*>> indexesTriangles;
-
-    // For each triangles
-    for (auto& t : triangles) {
-        // For each index of that triangles
-        for (int i = 0; i < 3; ++i) {
-            // Associate that triangle to that index
-            if (indexesTriangles.size() <= t[i]) indexesTriangles.resize(t[i] + 1, vector<glm::uvec3*>({}));
-            indexesTriangles[t[i]].push_back(&t);
+    const unsigned int none = ~0u;
+    const uint64_t emptyKey = ~uint64_t(0);
+
+    // Above this many triangles the indexes are written by several threads
+    const size_t parallelTriangles = 1 << 16;
+
+    // Undirected edge, both of its half edges give the same key
+    uint64_t edgeKey(unsigned int a, unsigned int b)
+    {
+        return a < b ? uint64_t(a) << 32 | b : uint64_t(b) << 32 | a;
+    }
+
+    // Open addressing table of the edges, to the first half edge
+    // (triangle * 3 + corner) met on each of them
+    struct Edge
+    {
+        uint64_t key;
+        unsigned int first;
+        bool shared;
+    };
+
+    struct EdgeTable
+    {
+        vector<Edge> edges;
+        // Half edge across each half edge, found as the second one is inserted
+        vector<unsigned int> partners;
+        size_t mask;
+
+        EdgeTable(size_t halfEdges)
+            : partners(halfEdges, none)
+        {
+            // Open meshes can have as many edges as half edges, keep the load under a half
+            size_t capacity = 16;
+            while (capacity < halfEdges * 2) capacity *= 2;
+            edges.assign(capacity, {emptyKey, none, false});
+            mask = capacity - 1;
+        }
+
+        // Both vertexes of the key are mixed, as OBJ::merge does
+        size_t slot(uint64_t key) const
+        {
+            return size_t(key * 0x9E3779B97F4A7C15ull >> 32) & mask;
+        }
+
+        void prefetch(uint64_t key) const
+        {
+#if defined(__GNUC__)
+            __builtin_prefetch(&edges[slot(key)]);
+#endif
+        }
+
+        // The first two half edges of an edge are each other's partner, the
+        // next ones are given the first
+        void insert(uint64_t key, unsigned int halfEdge)
+        {
+            size_t slot = this->slot(key);
+            while (edges[slot].key != emptyKey && edges[slot].key != key) slot = (slot + 1) & mask;
+            Edge& edge = edges[slot];
+            if (edge.key == emptyKey) {
+                edge.key = key;
+                edge.first = halfEdge;
+                return;
+            }
+            partners[halfEdge] = edge.first;
+            if (!edge.shared) partners[edge.first] = halfEdge;
+            edge.shared = true;
         }
+
+        unsigned int partner(unsigned int halfEdge) const
+        {
+            return partners[halfEdge];
+        }
+    };
+
+    // Slots are spread over the whole table, they are fetched some half edges ahead
+    const unsigned int prefetchDistance = 32;
+
+    uint64_t halfEdgeKey(const vector<glm::uvec3> &triangles, size_t halfEdge)
+    {
+        const glm::uvec3 &triangle = triangles[halfEdge / 3];
+        const unsigned int i = unsigned(halfEdge % 3);
+        return edgeKey(triangle[i], triangle[(i + 1) % 3]);
     }
 
-    // For each triangles
-    for (auto& t : triangles) {
-        // For each index of that triangles
-        for (int ti = 0; ti < 3; ti ++) {
-            bool matched = false;
-            // For each triangles sharing this index
-            for (auto& n : indexesTriangles[t[ti]]) {
-                if (matched) break;
-                if (*n == t) continue;
-                // For each of its edge
-                for (int ni = 0; ni < 3; ni ++) {
-                    unsigned int t1_A = t[ti];
-                    unsigned int t1_B = t[(ti + 1) % 3];
-                    unsigned int t2_A = (*n)[ni];
-                    unsigned int t2_B = (*n)[(ni + 1) % 3];
-                    if ((t1_A == t2_A && t1_B == t2_B) || (t1_A == t2_B && t1_B == t2_A)) {
-                        indexes.push_back(t[ti]);
-                        indexes.push_back((*n)[(ni + 2) % 3]);
-                        matched = true;
-                        break;
-                    }
-                }
+    void writeAdjacency(const vector<glm::uvec3> &triangles, const EdgeTable &edges, size_t begin, size_t end, unsigned int *out)
+    {
+        for (size_t t = begin; t < end; t ++) {
+            const glm::uvec3 &triangle = triangles[t];
+            for (unsigned int i = 0; i < 3; i ++) {
+                const unsigned int other = edges.partner(unsigned(t * 3 + i));
+                out[t * 6 + i * 2] = triangle[i];
+                out[t * 6 + i * 2 + 1] = other == none ? triangle[(i + 2) % 3] : triangles[other / 3][(other % 3 + 2) % 3];
             }
         }
     }
 }
+
+void generateTrianglesAdjacencyIndex(const vector<glm::uvec3> &triangles, vector<unsigned int> &indexes)
+{
+    const size_t halfEdges = triangles.size() * 3;
+    EdgeTable edges(halfEdges);
+    for (size_t h = 0; h < halfEdges; h ++) {
+        if (h + prefetchDistance < halfEdges) edges.prefetch(halfEdgeKey(triangles, h + prefetchDistance));
+        edges.insert(halfEdgeKey(triangles, h), unsigned(h));
+    }
+
+    // The table is only read from here, each thread writes its own triangles
+    const size_t first = indexes.size();
+    indexes.resize(first + triangles.size() * 6);
+    unsigned int *out = indexes.data() + first;
+
+    // The calling thread takes its share while it waits
+    const unsigned int threads = threadPool().size() + 1;
+    if (triangles.size() < parallelTriangles) {
+        writeAdjacency(triangles, edges, 0, triangles.size(), out);
+        return;
+    }
+
+    ThreadPool::Group group;
+    const size_t chunk = (triangles.size() + threads - 1) / threads;
+    for (size_t begin = 0; begin < triangles.size(); begin += chunk) {
+        const size_t end = min(begin + chunk, triangles.size());
+        threadPool().enqueue([&triangles, &edges, begin, end, out]() { writeAdjacency(triangles, edges, begin, end, out); }, ThreadPool::NORMAL, &group);
+    }
+    threadPool().wait(group);
+}
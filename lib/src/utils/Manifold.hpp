@@ -2,4 +2,8 @@
 #include <glm/fwd.hpp>
 #include <vector>
 
-void generateTrianglesAdjacencyIndex(std::vector<glm::uvec3> &triangles, std::vector<unsigned int> &indexes);
+// Append 6 indexes per triangle for GL_TRIANGLES_ADJACENCY: each corner followed
+// by the far vertex of the triangle across the edge it starts. Edges without a
+// neighbor use the triangle's own far vertex, edges shared by more than two
+// triangles use the first other triangle met on them.
+void generateTrianglesAdjacencyIndex(const std::vector<glm::uvec3> &triangles, std::vector<unsigned int> &indexes);
@@ -0,0 +1,77 @@
+#include "MappedFile.hpp"
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_MMAP
+#endif
+
+using namespace std;
+
+MappedFile::MappedFile()
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const string& filename)
+{
+    close();
+
+#ifdef MAPPED_FILE_MMAP
+    const int descriptor = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0) return false;
+
+    struct stat status;
+    if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+        void* address = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (address != MAP_FAILED) {
+            bytes = static_cast<const unsigned char*>(address);
+            length = size_t(status.st_size);
+            mapped = true;
+        }
+    }
+    ::close(descriptor);
+    if (mapped) return true;
+#endif
+
+    // Empty files can't be mapped, and some platforms can't map at all
+    ifstream file(filename, ios::binary | ios::ate);
+    if (!file) return false;
+    buffer.resize(size_t(file.tellg()));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(buffer.data()), streamsize(buffer.size()))) {
+        buffer.clear();
+        return false;
+    }
+    bytes = buffer.data();
+    length = buffer.size();
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef MAPPED_FILE_MMAP
+    if (mapped) munmap(const_cast<unsigned char*>(bytes), length);
+#endif
+    bytes = nullptr;
+    length = 0;
+    mapped = false;
+    buffer.clear();
+}
+
+const unsigned char* MappedFile::data() const
+{
+    return bytes;
+}
+
+size_t MappedFile::size() const
+{
+    return length;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// A file mapped read only in memory, pages are read on first access instead
+// of copied up front. Falls back to reading the whole file without mmap.
+class MappedFile
+{
+
+public:
+
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Unmap the previous file, return false when filename can't be read
+    bool open(const std::string& filename);
+    void close();
+
+    const unsigned char* data() const;
+    size_t size() const;
+
+private:
+
+    const unsigned char* bytes = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    std::vector<unsigned char> buffer;
+};
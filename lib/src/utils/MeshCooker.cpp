@@ -0,0 +1,143 @@
+#include "MeshCooker.hpp"
+#include "MappedFile.hpp"
+#include "Hash.hpp"
+#include "Log.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+using namespace std;
+using namespace glm;
+
+namespace
+{
+    const char magic[4] {'T', 'W', 'M', 'S'};
+    // Bumped whenever what is cooked changes, not only its layout
+    const uint32_t version = 5;
+
+    // Streams start on 16 bytes boundaries, so the mapping can be read in place
+    const size_t alignment = 16;
+
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t source;
+        uint32_t vertexes;
+        uint32_t lods;
+    };
+
+    // Follows the header, once per lod
+    struct LodHeader
+    {
+        uint32_t indexes;
+        uint32_t adjacencyIndexes;
+        float error;
+        uint32_t padding;
+    };
+
+    size_t align(size_t offset)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    template <typename T>
+    bool point(const MappedFile& mapping, size_t& offset, size_t count, Span<T>& span)
+    {
+        const size_t start = align(offset);
+        if (start + count * sizeof(T) > mapping.size()) return false;
+        span = Span<T>(reinterpret_cast<const T*>(mapping.data() + start), count);
+        offset = start + count * sizeof(T);
+        return true;
+    }
+
+    template <typename T>
+    void write(ofstream& file, size_t& offset, const Span<T>& span)
+    {
+        const char zeros[alignment] {};
+        const size_t start = align(offset);
+        file.write(zeros, streamsize(start - offset));
+        file.write(reinterpret_cast<const char*>(span.data()), streamsize(span.size() * sizeof(T)));
+        offset = start + span.size() * sizeof(T);
+    }
+}
+
+bool loadCookedMesh(const char* filename, MappedFile& mapping, MeshStreams& streams, uint64_t& source)
+{
+    if (!mapping.open(filename)) {
+        error("MeshCooker: could not read", filename);
+        source = 0;
+        return false;
+    }
+    source = fnv1a(mapping.data(), mapping.size());
+
+    if (!mapping.open(string(filename) + ".cooked") || mapping.size() < sizeof(Header)) return false;
+
+    Header header;
+    memcpy(&header, mapping.data(), sizeof(Header));
+    if (memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version || header.source != source) return false;
+
+    size_t offset = sizeof(Header);
+    if (header.lods == 0 || offset + header.lods * sizeof(LodHeader) > mapping.size()) return false;
+    vector<LodHeader> lods(header.lods);
+    memcpy(lods.data(), mapping.data() + offset, lods.size() * sizeof(LodHeader));
+    offset += lods.size() * sizeof(LodHeader);
+
+    bool mapped = point(mapping, offset, header.vertexes, streams.vertexes)
+        && point(mapping, offset, header.vertexes, streams.uvs)
+        && point(mapping, offset, header.vertexes, streams.normals)
+        && point(mapping, offset, header.vertexes, streams.tangents)
+        && point(mapping, offset, header.vertexes, streams.bitangents);
+    streams.lods.assign(lods.size(), MeshLod());
+    for (unsigned int i = 0; i < lods.size() && mapped; i ++) {
+        streams.lods[i].error = lods[i].error;
+        mapped = point(mapping, offset, lods[i].indexes, streams.lods[i].indexes)
+            && point(mapping, offset, lods[i].adjacencyIndexes, streams.lods[i].adjacencyIndexes);
+    }
+    return mapped;
+}
+
+void writeCookedMesh(const char* filename, uint64_t source, const MeshStreams& streams)
+{
+    const size_t vertexes = streams.vertexes.size();
+    if (streams.uvs.size() != vertexes || streams.normals.size() != vertexes
+        || streams.tangents.size() != vertexes || streams.bitangents.size() != vertexes || streams.lods.empty()) {
+        warning("MeshCooker: streams of different sizes, not cooking", filename);
+        return;
+    }
+
+    Header header {};
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.source = source;
+    header.vertexes = uint32_t(vertexes);
+    header.lods = uint32_t(streams.lods.size());
+
+    // Written aside then renamed, meshes still mapping the previous copy keep reading it
+    const string cooked = string(filename) + ".cooked";
+    const string written = cooked + ".tmp";
+    ofstream file(written, ios::binary | ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    for (auto& lod : streams.lods) {
+        LodHeader lodHeader {};
+        lodHeader.indexes = uint32_t(lod.indexes.size());
+        lodHeader.adjacencyIndexes = uint32_t(lod.adjacencyIndexes.size());
+        lodHeader.error = lod.error;
+        file.write(reinterpret_cast<const char*>(&lodHeader), sizeof(LodHeader));
+    }
+    size_t offset = sizeof(Header) + streams.lods.size() * sizeof(LodHeader);
+    write(file, offset, streams.vertexes);
+    write(file, offset, streams.uvs);
+    write(file, offset, streams.normals);
+    write(file, offset, streams.tangents);
+    write(file, offset, streams.bitangents);
+    for (auto& lod : streams.lods) {
+        write(file, offset, lod.indexes);
+        write(file, offset, lod.adjacencyIndexes);
+    }
+    file.close();
+    if (!file || rename(written.c_str(), cooked.c_str()) != 0) {
+        warning("MeshCooker: could not write", cooked);
+        remove(written.c_str());
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "Span.hpp"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+class MappedFile;
+
+// Triangles of a level of detail, over the vertexes of the full mesh.
+// error is how far it strays from the full mesh, relative to its radius
+struct MeshLod
+{
+    Span<unsigned int> indexes;
+    Span<unsigned int> adjacencyIndexes;
+    float error = 0.f;
+};
+
+// Final vertex streams and indexes of a mesh, as uploaded. Every vertex
+// stream holds one item per vertex, lods go from the full mesh to the coarsest
+struct MeshStreams
+{
+    Span<glm::vec4> vertexes;
+    Span<glm::vec2> uvs;
+    Span<glm::vec3> normals;
+    Span<glm::vec3> tangents;
+    Span<glm::vec3> bitangents;
+    std::vector<MeshLod> lods;
+};
+
+// Map the cooked copy of a mesh, filename.cooked, and point streams into the
+// mapping. Return false when the copy is missing, of another format version
+// or made from other content: source is then the hash to cook it with
+bool loadCookedMesh(const char* filename, MappedFile& mapping, MeshStreams& streams, uint64_t& source);
+
+// Write filename.cooked, made from the content hashed as source
+void writeCookedMesh(const char* filename, uint64_t source, const MeshStreams& streams);
@@ -0,0 +1,240 @@
+#include "MeshOptimizer.hpp"
+#include <algorithm>
+#include <numeric>
+
+using namespace std;
+using namespace glm;
+
+namespace
+{
+    // FIFO post-transform cache, as most GPUs have
+    class Cache
+    {
+
+    public:
+
+        Cache(size_t vertexCount, unsigned int size)
+            : stamps(vertexCount, 0)
+            , size(size)
+        {}
+
+        // Return true on a miss
+        bool use(unsigned int vertex)
+        {
+            if (stamps[vertex] != 0 && time - stamps[vertex] < size) return false;
+            stamps[vertex] = ++ time;
+            return true;
+        }
+
+        void clear()
+        {
+            time += size;
+        }
+
+    private:
+
+        std::vector<unsigned int> stamps;
+        unsigned int size;
+        unsigned int time = 0;
+    };
+
+    unsigned int misses(Cache& cache, const unsigned int* triangle)
+    {
+        return unsigned(cache.use(triangle[0])) + unsigned(cache.use(triangle[1])) + unsigned(cache.use(triangle[2]));
+    }
+}
+
+VertexCacheStatistics analyzeVertexCache(const vector<unsigned int>& indexes, size_t vertexCount, unsigned int cacheSize)
+{
+    VertexCacheStatistics statistics;
+    if (indexes.size() < 3 || vertexCount == 0) return statistics;
+
+    Cache cache(vertexCount, cacheSize);
+    unsigned int transformed = 0;
+    for (size_t i = 0; i + 2 < indexes.size(); i += 3) {
+        transformed += misses(cache, &indexes[i]);
+    }
+
+    // Only vertexes actually drawn count
+    vector<bool> used(vertexCount, false);
+    size_t usedCount = 0;
+    for (unsigned int index : indexes) {
+        if (!used[index]) usedCount ++;
+        used[index] = true;
+    }
+
+    statistics.acmr = float(transformed) / float(indexes.size() / 3);
+    statistics.atvr = float(transformed) / float(usedCount);
+    return statistics;
+}
+
+void optimizeVertexCache(vector<unsigned int>& indexes, size_t vertexCount, unsigned int cacheSize)
+{
+    const size_t triangleCount = indexes.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0) return;
+
+    // Triangles using each vertex, and how many of them are still to emit
+    vector<unsigned int> live(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i ++) live[indexes[i]] ++;
+    vector<unsigned int> offsets(vertexCount + 1, 0);
+    partial_sum(live.begin(), live.end(), offsets.begin() + 1);
+    vector<unsigned int> vertexTriangles(offsets.back());
+    vector<unsigned int> filled(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; t ++) {
+        for (unsigned int j = 0; j < 3; j ++) {
+            vertexTriangles[filled[indexes[t * 3 + j]] ++] = unsigned(t);
+        }
+    }
+
+    vector<unsigned int> stamps(vertexCount, 0);
+    vector<bool> emitted(triangleCount, false);
+    vector<unsigned int> deadEnds;
+    vector<unsigned int> candidates;
+    vector<unsigned int> result;
+    result.reserve(triangleCount * 3);
+
+    unsigned int time = cacheSize + 1;
+    unsigned int cursor = 0;
+    int fanning = int(indexes[0]);
+
+    while (fanning >= 0) {
+
+        // Emit every triangle around the fanning vertex
+        candidates.clear();
+        for (unsigned int k = offsets[unsigned(fanning)]; k < offsets[unsigned(fanning) + 1]; k ++) {
+            const unsigned int t = vertexTriangles[k];
+            if (emitted[t]) continue;
+            for (unsigned int j = 0; j < 3; j ++) {
+                const unsigned int v = indexes[t * 3 + j];
+                result.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                live[v] --;
+                if (time - stamps[v] > cacheSize) stamps[v] = time ++;
+            }
+            emitted[t] = true;
+        }
+
+        // Next fan around the candidate which stays longest in cache with triangles left
+        fanning = -1;
+        int best = -1;
+        for (unsigned int v : candidates) {
+            if (live[v] == 0) continue;
+            int priority = 0;
+            if (time - stamps[v] + 2 * live[v] <= cacheSize) priority = int(time - stamps[v]);
+            if (priority > best) {
+                best = priority;
+                fanning = int(v);
+            }
+        }
+
+        // Dead end: the most recent vertex with triangles left, or the next one in input order
+        while (fanning < 0 && !deadEnds.empty()) {
+            const unsigned int v = deadEnds.back();
+            deadEnds.pop_back();
+            if (live[v] > 0) fanning = int(v);
+        }
+        while (fanning < 0 && cursor < vertexCount) {
+            if (live[cursor] > 0) fanning = int(cursor);
+            cursor ++;
+        }
+    }
+
+    // Indexes past the last whole triangle are dropped
+    indexes.swap(result);
+}
+
+void optimizeOverdraw(vector<unsigned int>& indexes, const vector<vec4>& positions, float threshold, unsigned int cacheSize)
+{
+    const size_t triangleCount = indexes.size() / 3;
+    if (triangleCount < 2) return;
+
+    // Hard boundaries where the cache had nothing to reuse, then cut each
+    // cluster again where its running ACMR, from a cold cache, is good enough
+    vector<size_t> clusters;
+    {
+        Cache cache(positions.size(), cacheSize);
+        vector<size_t> hard;
+        for (size_t t = 0; t < triangleCount; t ++) {
+            if (misses(cache, &indexes[t * 3]) == 3) hard.push_back(t);
+        }
+        hard.push_back(triangleCount);
+
+        for (size_t h = 0; h + 1 < hard.size(); h ++) {
+            const size_t start = hard[h];
+            const size_t end = hard[h + 1];
+
+            Cache clusterCache(positions.size(), cacheSize);
+            unsigned int clusterMisses = 0;
+            for (size_t t = start; t < end; t ++) clusterMisses += misses(clusterCache, &indexes[t * 3]);
+            const float clusterACMR = float(clusterMisses) / float(end - start);
+
+            clusterCache.clear();
+            clusters.push_back(start);
+            unsigned int runningMisses = 0;
+            size_t runningStart = start;
+            for (size_t t = start; t < end; t ++) {
+                runningMisses += misses(clusterCache, &indexes[t * 3]);
+                if (t + 1 < end && float(runningMisses) / float(t + 1 - runningStart) <= threshold * clusterACMR) {
+                    clusters.push_back(t + 1);
+                    clusterCache.clear();
+                    runningMisses = 0;
+                    runningStart = t + 1;
+                }
+            }
+        }
+        clusters.push_back(triangleCount);
+    }
+
+    // Clusters facing away from the mesh's center are drawn first
+    vec3 center(0.f);
+    for (unsigned int index : indexes) center += vec3(positions[index]);
+    center /= float(indexes.size());
+
+    const size_t clusterCount = clusters.size() - 1;
+    vector<float> keys(clusterCount);
+    for (size_t c = 0; c < clusterCount; c ++) {
+        vec3 centroid(0.f);
+        vec3 normal(0.f);
+        float area = 0.f;
+        for (size_t t = clusters[c]; t < clusters[c + 1]; t ++) {
+            const vec3 a = vec3(positions[indexes[t * 3]]);
+            const vec3 b = vec3(positions[indexes[t * 3 + 1]]);
+            const vec3 d = vec3(positions[indexes[t * 3 + 2]]);
+            const vec3 n = cross(b - a, d - a);
+            const float triangleArea = length(n);
+            centroid += (a + b + d) * (triangleArea / 3.f);
+            normal += n;
+            area += triangleArea;
+        }
+        centroid = area > 0.f ? centroid / area : vec3(positions[indexes[clusters[c] * 3]]);
+        const float normalLength = length(normal);
+        keys[c] = normalLength > 0.f ? dot(centroid - center, normal / normalLength) : 0.f;
+    }
+
+    vector<size_t> order(clusterCount);
+    iota(order.begin(), order.end(), size_t(0));
+    stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+    vector<unsigned int> result;
+    result.reserve(triangleCount * 3);
+    for (size_t c : order) {
+        result.insert(result.end(), indexes.begin() + long(clusters[c] * 3), indexes.begin() + long(clusters[c + 1] * 3));
+    }
+    indexes.swap(result);
+}
+
+vector<unsigned int> optimizeVertexFetch(vector<unsigned int>& indexes, size_t vertexCount)
+{
+    const unsigned int unused = ~0u;
+    vector<unsigned int> remap(vertexCount, unused);
+    unsigned int next = 0;
+    for (auto& index : indexes) {
+        if (remap[index] == unused) remap[index] = next ++;
+        index = remap[index];
+    }
+    for (auto& destination : remap) {
+        if (destination == unused) destination = next ++;
+    }
+    return remap;
+}
@@ -0,0 +1,232 @@
+#include "MeshSimplifier.hpp"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+using namespace std;
+using namespace glm;
+
+namespace
+{
+    // Symmetric 4x4 matrix of the squared distances to a set of planes
+    struct Quadric
+    {
+        double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+        double a11 = 0, a12 = 0, a13 = 0;
+        double a22 = 0, a23 = 0;
+        double a33 = 0;
+        double planes = 0;
+
+        void addPlane(const dvec3& n, double d)
+        {
+            a00 += n.x * n.x; a01 += n.x * n.y; a02 += n.x * n.z; a03 += n.x * d;
+            a11 += n.y * n.y; a12 += n.y * n.z; a13 += n.y * d;
+            a22 += n.z * n.z; a23 += n.z * d;
+            a33 += d * d;
+            planes += 1;
+        }
+
+        void add(const Quadric& q)
+        {
+            a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+            a11 += q.a11; a12 += q.a12; a13 += q.a13;
+            a22 += q.a22; a23 += q.a23;
+            a33 += q.a33;
+            planes += q.planes;
+        }
+
+        // Mean squared distance to the planes
+        double evaluate(const dvec3& p) const
+        {
+            if (planes == 0) return 0;
+            return (a00 * p.x * p.x + 2 * a01 * p.x * p.y + 2 * a02 * p.x * p.z + 2 * a03 * p.x
+                 + a11 * p.y * p.y + 2 * a12 * p.y * p.z + 2 * a13 * p.y
+                 + a22 * p.z * p.z + 2 * a23 * p.z
+                 + a33) / planes;
+        }
+    };
+
+    struct Collapse
+    {
+        unsigned int from;
+        unsigned int to;
+        double cost;
+    };
+
+    uint64_t edgeKey(unsigned int a, unsigned int b)
+    {
+        return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+    }
+
+    // Items of each key, as offsets in a flat list
+    struct Buckets
+    {
+        vector<unsigned int> offsets;
+        vector<unsigned int> items;
+
+        const unsigned int* begin(unsigned int key) const { return items.data() + offsets[key]; }
+        const unsigned int* end(unsigned int key) const { return items.data() + offsets[key + 1]; }
+    };
+
+    template <typename F>
+    Buckets bucket(size_t keyCount, size_t itemCount, F keyOf)
+    {
+        Buckets buckets;
+        buckets.offsets.assign(keyCount + 1, 0);
+        for (size_t i = 0; i < itemCount; i ++) buckets.offsets[keyOf(i) + 1] ++;
+        for (size_t k = 0; k < keyCount; k ++) buckets.offsets[k + 1] += buckets.offsets[k];
+        buckets.items.resize(itemCount);
+        vector<unsigned int> filled(buckets.offsets.begin(), buckets.offsets.end() - 1);
+        for (size_t i = 0; i < itemCount; i ++) buckets.items[filled[keyOf(i)] ++] = unsigned(i);
+        return buckets;
+    }
+}
+
+vector<unsigned int> simplifyMesh(
+    const vector<unsigned int>& indexes,
+    const vector<vec4>& vertexes,
+    const vector<vec3>& normals,
+    const vector<vec2>& uvs,
+    const vector<unsigned int>& positions,
+    size_t targetIndexCount,
+    float& error
+) {
+    error = 0.f;
+    vector<unsigned int> result(indexes.begin(), indexes.begin() + long(indexes.size() / 3 * 3));
+    if (result.size() <= targetIndexCount || vertexes.empty() || positions.size() != vertexes.size()) return result;
+
+    const size_t positionCount = *max_element(positions.begin(), positions.end()) + size_t(1);
+    const Buckets positionVertexes = bucket(positionCount, positions.size(), [&positions](size_t v) { return positions[v]; });
+
+    vector<dvec3> points(positionCount);
+    for (size_t v = 0; v < vertexes.size(); v ++) points[positions[v]] = dvec3(vec3(vertexes[v]));
+
+    // Around the origin, as Mesh::getRadius is, since errors are scaled back by it
+    double radius = 0.0;
+    for (auto& point : points) radius = max(radius, length(point));
+    if (radius <= 0.0) return result;
+
+    // Unweighted planes, so costs are squared distances to the original surface
+    vector<Quadric> quadrics(positionCount);
+    unordered_map<uint64_t, unsigned int> edges;
+    for (size_t i = 0; i < result.size(); i += 3) {
+        const unsigned int p[3] {positions[result[i]], positions[result[i + 1]], positions[result[i + 2]]};
+        const dvec3 n = cross(points[p[1]] - points[p[0]], points[p[2]] - points[p[0]]);
+        const double l = length(n);
+        if (l > 0.0) {
+            for (unsigned int j = 0; j < 3; j ++) quadrics[p[j]].addPlane(n / l, -dot(n / l, points[p[0]]));
+        }
+        for (unsigned int j = 0; j < 3; j ++) edges[edgeKey(p[j], p[(j + 1) % 3])] ++;
+    }
+
+    // Positions on a border or a non manifold edge stay
+    vector<bool> locked(positionCount, false);
+    for (auto& edge : edges) {
+        if (edge.second == 2) continue;
+        locked[unsigned(edge.first >> 32)] = true;
+        locked[unsigned(edge.first & 0xffffffffu)] = true;
+    }
+
+    const double attributeWeight = 1.0;
+    double largestCost = 0.0;
+    vector<unsigned int> moved(positionCount);
+    vector<bool> touched(positionCount);
+    vector<Collapse> collapses;
+
+    size_t triangleCount = result.size() / 3;
+    const size_t targetTriangles = targetIndexCount / 3;
+
+    while (triangleCount > targetTriangles) {
+
+        // Cheapest collapse of every edge
+        collapses.clear();
+        edges.clear();
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (unsigned int j = 0; j < 3; j ++) {
+                const unsigned int a = positions[result[i + j]];
+                const unsigned int b = positions[result[i + (j + 1) % 3]];
+                if (!edges.insert(make_pair(edgeKey(a, b), 0u)).second) continue;
+
+                Quadric q = quadrics[a];
+                q.add(quadrics[b]);
+                const double toB = locked[a] ? HUGE_VAL : q.evaluate(points[b]);
+                const double toA = locked[b] ? HUGE_VAL : q.evaluate(points[a]);
+                if (toB == HUGE_VAL && toA == HUGE_VAL) continue;
+                collapses.push_back(toB <= toA ? Collapse {a, b, toB} : Collapse {b, a, toA});
+            }
+        }
+        sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        const Buckets positionTriangles = bucket(positionCount, result.size(), [&positions, &result](size_t i) { return positions[result[i]]; });
+        for (unsigned int p = 0; p < positionCount; p ++) moved[p] = p;
+        fill(touched.begin(), touched.end(), false);
+
+        // Collapses around positions already changed in this pass wait for the next one
+        size_t remaining = triangleCount;
+        for (auto& collapse : collapses) {
+            if (remaining <= targetTriangles) break;
+            if (touched[collapse.from] || touched[collapse.to]) continue;
+
+            bool flips = false;
+            unsigned int removed = 0;
+            for (const unsigned int* k = positionTriangles.begin(collapse.from); k != positionTriangles.end(collapse.from) && !flips; k ++) {
+                const size_t t = *k / 3 * 3;
+                const unsigned int p[3] {positions[result[t]], positions[result[t + 1]], positions[result[t + 2]]};
+                if (p[0] == collapse.to || p[1] == collapse.to || p[2] == collapse.to) {
+                    removed ++;
+                    continue;
+                }
+                dvec3 q[3] {points[p[0]], points[p[1]], points[p[2]]};
+                const dvec3 before = cross(q[1] - q[0], q[2] - q[0]);
+                for (unsigned int j = 0; j < 3; j ++) {
+                    if (p[j] == collapse.from) q[j] = points[collapse.to];
+                }
+                const dvec3 after = cross(q[1] - q[0], q[2] - q[0]);
+                flips = dot(before, after) <= 0.0;
+            }
+            if (flips) continue;
+
+            moved[collapse.from] = collapse.to;
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            largestCost = max(largestCost, collapse.cost);
+            remaining -= removed;
+
+            for (const unsigned int* k = positionTriangles.begin(collapse.from); k != positionTriangles.end(collapse.from); k ++) {
+                const size_t t = *k / 3 * 3;
+                for (unsigned int j = 0; j < 3; j ++) touched[positions[result[t + j]]] = true;
+            }
+        }
+        if (remaining == triangleCount) break;
+
+        // Move the triangles' corners to a vertex of their new position, dropping collapsed triangles
+        size_t written = 0;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            unsigned int corners[3];
+            for (unsigned int j = 0; j < 3; j ++) {
+                const unsigned int vertex = result[i + j];
+                const unsigned int to = moved[positions[vertex]];
+                corners[j] = vertex;
+                if (to == positions[vertex]) continue;
+
+                double best = HUGE_VAL;
+                for (const unsigned int* w = positionVertexes.begin(to); w != positionVertexes.end(to); w ++) {
+                    const vec3 n = (*w < normals.size() ? normals[*w] : vec3(0.f)) - (vertex < normals.size() ? normals[vertex] : vec3(0.f));
+                    const vec2 uv = (*w < uvs.size() ? uvs[*w] : vec2(0.f)) - (vertex < uvs.size() ? uvs[vertex] : vec2(0.f));
+                    const double distance = dot(n, n) + attributeWeight * dot(uv, uv);
+                    if (distance < best) {
+                        best = distance;
+                        corners[j] = *w;
+                    }
+                }
+            }
+            const unsigned int p[3] {positions[corners[0]], positions[corners[1]], positions[corners[2]]};
+            if (p[0] == p[1] || p[1] == p[2] || p[0] == p[2]) continue;
+            for (unsigned int j = 0; j < 3; j ++) result[written ++] = corners[j];
+        }
+        result.resize(written);
+        triangleCount = written / 3;
+    }
+
+    error = float(sqrt(largestCost) / radius);
+    return result;
+}
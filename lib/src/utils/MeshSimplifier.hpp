@@ -0,0 +1,26 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+// Quadric error edge collapse (Garland and Heckbert 1997). Collapses move a
+// position onto one of its neighbors, so the simplified triangles index the
+// same vertexes as the full mesh and share its vertex buffers.
+//
+// positions tells the position each vertex was made from: vertexes split on
+// uv seams and hard edges move together, each triangle corner then takes the
+// vertex of the new position closest in normal and uv. Positions on borders
+// never move.
+//
+// Return indexes, 3 per triangle, of at most targetIndexCount indexes when
+// reachable. error receives the largest distance to the original surface,
+// relative to the radius of the bounds around the origin.
+std::vector<unsigned int> simplifyMesh(
+    const std::vector<unsigned int>& indexes,
+    const std::vector<glm::vec4>& vertexes,
+    const std::vector<glm::vec3>& normals,
+    const std::vector<glm::vec2>& uvs,
+    const std::vector<unsigned int>& positions,
+    size_t targetIndexCount,
+    float& error
+);
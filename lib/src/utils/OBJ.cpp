@@ -1,133 +1,274 @@
 #include "OBJ.hpp"
 #include "Log.hpp"
-#include <glm/glm.hpp>
-#include <cstring>
-#include <assert.h>
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cstdint>
 
 using namespace std;
 using namespace glm;
 
-OBJ::OBJ(std::vector<glm::uvec3> &_triangles, std::vector<glm::vec4> &_vertexes, std::vector<glm::vec2> &_uvs, std::vector<glm::vec3> &_normals, std::vector<unsigned int> &_indexes)
+namespace
+{
+    bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    void skipSpaces(const char *&p, const char *end)
+    {
+        while (p < end && isSpace(*p)) p ++;
+    }
+
+    const char *lineEnd(const char *p, const char *end)
+    {
+        while (p < end && *p != '\n') p ++;
+        return p;
+    }
+
+    // Decimal float without locale nor allocation: digits are accumulated in
+    // an integer then scaled once, precise enough for single precision
+    float parseFloat(const char *&p, const char *end)
+    {
+        static const double powers[] {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18};
+
+        skipSpaces(p, end);
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+        uint64_t mantissa = 0;
+        int exponent = 0;
+        int digits = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; p ++) {
+            if (digits < 18) {
+                mantissa = mantissa * 10 + uint64_t(*p - '0');
+                if (mantissa) digits ++;
+            } else {
+                exponent ++;
+            }
+        }
+        if (p < end && *p == '.') {
+            for (p ++; p < end && *p >= '0' && *p <= '9'; p ++) {
+                if (digits < 18) {
+                    mantissa = mantissa * 10 + uint64_t(*p - '0');
+                    if (mantissa) digits ++;
+                    exponent --;
+                }
+            }
+        }
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            p ++;
+            bool negativeExponent = false;
+            if (p < end && (*p == '-' || *p == '+')) negativeExponent = *p++ == '-';
+            int e = 0;
+            for (; p < end && *p >= '0' && *p <= '9'; p ++) {
+                if (e < 1000) e = e * 10 + (*p - '0');
+            }
+            exponent += negativeExponent ? -e : e;
+        }
+
+        double value = double(mantissa);
+        while (exponent > 18) { value *= 1e18; exponent -= 18; }
+        while (exponent < -18) { value /= 1e18; exponent += 18; }
+        value = exponent < 0 ? value / powers[-exponent] : value * powers[exponent];
+        return float(negative ? -value : value);
+    }
+
+    int parseInt(const char *&p, const char *end)
+    {
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+        int value = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; p ++) {
+            value = value * 10 + (*p - '0');
+        }
+        return negative ? -value : value;
+    }
+
+    // v, v/vt, v//vn or v/vt/vn, missing indexes are 0
+    bool parsePoint(const char *&p, const char *end, ivec3 &point)
+    {
+        skipSpaces(p, end);
+        if (p >= end || *p == '\n') return false;
+        point = ivec3(parseInt(p, end), 0, 0);
+        for (int type = 1; type < 3 && p < end && *p == '/'; type ++) {
+            p ++;
+            point[type] = parseInt(p, end);
+        }
+        // Skip anything unexpected up to the next separator
+        while (p < end && !isSpace(*p) && *p != '\n') p ++;
+        return true;
+    }
+}
+
+OBJ::OBJ(std::vector<glm::uvec3> &_triangles, std::vector<glm::vec4> &_vertexes, std::vector<glm::vec2> &_uvs, std::vector<glm::vec3> &_normals, std::vector<unsigned int> &_indexes, std::vector<unsigned int> &_positions)
     : triangles(_triangles)
     , vertexes(_vertexes)
     , uvs(_uvs)
     , normals(_normals)
     , indexes(_indexes)
+    , positions(_positions)
 {}
 
-void OBJ::load(const char *filename)
+void OBJ::load(const char *filename, size_t chunkSize)
 {
-    ifstream fin;
-
-    if (openFile(filename, fin)) {
-        parseLines(fin);
-    } else {
+    MappedFile file;
+    if (!file.open(filename)) {
         error("OBJ not found:", filename);
+        return;
     }
 
-    triangles.shrink_to_fit();
-    vertexes.shrink_to_fit();
-    uvs.shrink_to_fit();
-    normals.shrink_to_fit();
-    indexes.shrink_to_fit();
+    // Cut on line ends, so every line is parsed by a single chunk
+    const char *begin = reinterpret_cast<const char*>(file.data());
+    const char *end = begin + file.size();
+    vector<pair<const char*, const char*>> ranges;
+    for (const char *start = begin; start < end;) {
+        const char *stop = start + min(max(chunkSize, size_t(1)), size_t(end - start));
+        stop = min(lineEnd(stop - 1, end) + 1, end);
+        ranges.push_back(make_pair(start, stop));
+        start = stop;
+    }
 
-    assert(vertexes.size() == uvs.size());
-    assert(vertexes.size() == normals.size());
-    assert(vertexes.size() <= indexes.size());
+    vector<Chunk> chunks(ranges.size());
+    if (ranges.size() > 1) {
+        ThreadPool::Group group;
+        for (unsigned int i = 0; i < ranges.size(); i ++) {
+            threadPool().enqueue([&ranges, &chunks, i]() { parseChunk(ranges[i].first, ranges[i].second, chunks[i]); }, ThreadPool::NORMAL, &group);
+        }
+        threadPool().wait(group);
+    } else if (ranges.size() == 1) {
+        parseChunk(ranges[0].first, ranges[0].second, chunks[0]);
+    }
 
-    success("OBJ loaded:", vertexes.size(), "vertexes,", triangles.size(), "triangles,", indexes.size(), "indexes,", filename);
-}
+    merge(chunks);
 
-bool OBJ::openFile(const char *filename, ifstream &fin)
-{
-    fin.open(filename);
-    return fin.good();
+    success("OBJ loaded:", positionCount, "positions,", vertexes.size(), "distinct v/vt/vn vertexes,", triangles.size(), "triangles,", filename);
 }
 
-void OBJ::parseLines(ifstream &fin)
+void OBJ::parseChunk(const char *p, const char *end, Chunk &chunk)
 {
-    // TODO add asserts to notify of unsuported file format
-    while (!fin.eof()) {
-        char k[7] {' '};
-        fin >> k;
-        if (strncmp(k, VT, 3) == 0) {
-            parseUVs(fin);
-        } else if (strncmp(k, VN, 3) == 0) {
-            parseNormal(fin);
-        } else if (strncmp(k, V, 2) == 0) {
-            parseVertex(fin);
-        } else if (strncmp(k, F, 2) == 0) {
-            parseFace(fin);
-        } else {
-            skipLine(fin);
+    vector<ivec4> polygon;
+    while (p < end) {
+        skipSpaces(p, end);
+        if (p + 1 < end && p[0] == 'v' && isSpace(p[1])) {
+            p += 2;
+            const float x = parseFloat(p, end);
+            const float y = parseFloat(p, end);
+            const float z = parseFloat(p, end);
+            chunk.vertexes.push_back(vec4(x, y, z, 1.f));
+        } else if (p + 2 < end && p[0] == 'v' && p[1] == 't' && isSpace(p[2])) {
+            p += 3;
+            const float u = parseFloat(p, end);
+            const float v = parseFloat(p, end);
+            chunk.uvs.push_back(vec2(u, v));
+        } else if (p + 2 < end && p[0] == 'v' && p[1] == 'n' && isSpace(p[2])) {
+            p += 3;
+            const float x = parseFloat(p, end);
+            const float y = parseFloat(p, end);
+            const float z = parseFloat(p, end);
+            chunk.normals.push_back(vec3(x, y, z));
+        } else if (p + 1 < end && p[0] == 'f' && isSpace(p[1])) {
+            p += 2;
+            // Negative indexes count back from the last element of the chunk so far
+            const ivec3 counts(int(chunk.vertexes.size()), int(chunk.uvs.size()), int(chunk.normals.size()));
+            polygon.clear();
+            ivec3 point;
+            while (parsePoint(p, end, point)) {
+                int relative = 0;
+                for (int type = 0; type < 3; type ++) {
+                    if (point[type] >= 0) continue;
+                    point[type] += counts[type] + 1;
+                    relative |= 1 << type;
+                }
+                polygon.push_back(ivec4(point, relative));
+            }
+            // Quads and n-gons are cut in a fan of triangles
+            for (size_t i = 2; i < polygon.size(); i ++) {
+                chunk.points.push_back(polygon[0]);
+                chunk.points.push_back(polygon[i - 1]);
+                chunk.points.push_back(polygon[i]);
+            }
         }
+        p = lineEnd(p, end) + 1;
     }
 }
 
-void OBJ::skipLine(ifstream &fin)
+void OBJ::merge(vector<Chunk> &chunks)
 {
-    char b[1] = {' '};
-    while (!fin.eof() && b[0] != '\n') {
-        fin.read(b, 1);
+    // Positive indexes count from the start of the file, negative ones were
+    // counted from their chunk's start, chunks are appended in order
+    vector<vec4> positionList;
+    vector<vec2> uvList;
+    vector<vec3> normalList;
+    vector<ivec3> bases;
+    size_t points = 0;
+    for (auto &chunk : chunks) {
+        bases.push_back(ivec3(int(positionList.size()), int(uvList.size()), int(normalList.size())));
+        positionList.insert(positionList.end(), chunk.vertexes.begin(), chunk.vertexes.end());
+        uvList.insert(uvList.end(), chunk.uvs.begin(), chunk.uvs.end());
+        normalList.insert(normalList.end(), chunk.normals.begin(), chunk.normals.end());
+        points += chunk.points.size();
     }
-}
+    const ivec3 counts(int(positionList.size()), int(uvList.size()), int(normalList.size()));
 
-void OBJ::parseVertex(ifstream &fin)
-{
-    GLfloat f1, f2, f3;
-    fin >> f1 >> f2 >> f3;
-    vertexes.push_back(vec4(f1, f2, f3, 1.0f));
-}
+    // Open addressing table of the v/vt/vn triples met so far, to their vertex
+    const unsigned int empty = ~0u;
+    size_t capacity = 16;
+    while (capacity < points * 2) capacity *= 2;
+    vector<unsigned int> table(capacity, empty);
+    vector<ivec3> keys;
+    keys.reserve(min(points, capacity / 2));
 
-void OBJ::parseUVs(ifstream &fin)
-{
-    GLfloat f1, f2;
-    fin >> f1 >> f2;
-    uvList.push_back(vec2(f1, f2));
-}
+    const unsigned int first = unsigned(vertexes.size());
+    indexes.reserve(indexes.size() + points);
+    triangles.reserve(triangles.size() + points / 3);
 
-void OBJ::parseNormal(ifstream &fin)
-{
-    GLfloat f1, f2, f3;
-    fin >> f1 >> f2 >> f3;
-    normalList.push_back(vec3(f1, f2, f3));
-}
+    for (unsigned int c = 0; c < chunks.size(); c ++) {
+        const vector<ivec4> &chunkPoints = chunks[c].points;
+        for (size_t i = 0; i + 2 < chunkPoints.size(); i += 3) {
 
-void OBJ::parseFace(ifstream &fin)
-{
-    unsigned int values[3] {0};
-    unsigned int faceIndexes[3] {0};
-    for (unsigned int point = 0; point < 3; point ++) {
-        for (unsigned int type = 0; type < 3; type ++) {
-            fin >> values[type];
-            skipNextChar(fin);
+            // 0 based triples, -1 for a missing uv or normal
+            ivec3 face[3];
+            bool valid = true;
+            for (unsigned int j = 0; j < 3; j ++) {
+                const ivec4 &point = chunkPoints[i + j];
+                for (int type = 0; type < 3; type ++) {
+                    const int index = ((point.w >> type) & 1 ? bases[c][type] : 0) + point[type] - 1;
+                    face[j][type] = index >= 0 && index < counts[type] ? index : -1;
+                }
+                valid = valid && face[j].x >= 0;
+            }
+            if (!valid) continue;
+
+            unsigned int triangle[3];
+            for (unsigned int j = 0; j < 3; j ++) {
+                const ivec3 &key = face[j];
+                size_t slot = size_t((uint64_t(unsigned(key.x)) * 73856093u ^ uint64_t(unsigned(key.y)) * 19349663u ^ uint64_t(unsigned(key.z)) * 83492791u) * 0x9E3779B97F4A7C15ull >> 32) & (capacity - 1);
+                while (table[slot] != empty && keys[table[slot]] != key) slot = (slot + 1) & (capacity - 1);
+                if (table[slot] == empty) {
+                    table[slot] = unsigned(keys.size());
+                    keys.push_back(key);
+                }
+                triangle[j] = first + table[slot];
+                indexes.push_back(triangle[j]);
+            }
+            triangles.push_back(uvec3(triangle[0], triangle[1], triangle[2]));
         }
-        faceIndexes[point] = values[0] - 1;
-        addPoint(values);
+        chunks[c] = Chunk();
     }
-    addTriangle(faceIndexes);
-}
-
-void OBJ::addPoint(unsigned int values[3])
-{
-    indexes.push_back(values[0] - 1);
-
-    uvs.resize(vertexes.size());
-    uvs[values[0] - 1] = uvList[values[1] - 1];
-
-    normals.resize(vertexes.size());
-    normals[values[0] - 1] = normalList[values[2] - 1];
-}
-
-void OBJ::addTriangle(unsigned int values[3])
-{
-    triangles.push_back(uvec3(values[0], values[1], values[2]));
-}
 
-void OBJ::skipNextChar(std::ifstream &fin)
-{
-    fin.clear();
-    fin.ignore();
+    // One vertex per distinct triple, positions shared across uv seams and hard edges are split
+    vertexes.reserve(vertexes.size() + keys.size());
+    uvs.reserve(uvs.size() + keys.size());
+    normals.reserve(normals.size() + keys.size());
+    positions.reserve(positions.size() + keys.size());
+    for (auto &key : keys) {
+        vertexes.push_back(positionList[size_t(key.x)]);
+        uvs.push_back(key.y >= 0 ? uvList[size_t(key.y)] : vec2(0.f));
+        normals.push_back(key.z >= 0 ? normalList[size_t(key.z)] : vec3(0.f));
+        positions.push_back(unsigned(key.x));
+    }
+    positionCount = positionList.size();
 }
 
 void OBJ::debug()
@@ -1,45 +1,49 @@
 #pragma once
 #include <OpenGL.hpp>
-#include <glm/fwd.hpp>
+#include <glm/glm.hpp>
+#include <cstddef>
 #include <vector>
-#include <fstream>
 
 class OBJ
 {
 
 public:
 
-    OBJ(std::vector<glm::uvec3> &_triangles, std::vector<glm::vec4> &_vertexes, std::vector<glm::vec2> &_uvs, std::vector<glm::vec3> &_normals, std::vector<unsigned int> &_indexes);
+    OBJ(std::vector<glm::uvec3> &_triangles, std::vector<glm::vec4> &_vertexes, std::vector<glm::vec2> &_uvs, std::vector<glm::vec3> &_normals, std::vector<unsigned int> &_indexes, std::vector<unsigned int> &_positions);
 
-    void load(const char *filename);
+    // Every distinct v/vt/vn triple of the faces becomes a vertex, positions
+    // tells the position each vertex was made from. Quads and n-gons are
+    // triangulated, negative indexes count back from the last element read.
+    // The file is mapped and cut in chunks of about chunkSize bytes, ending on
+    // a line end, parsed in parallel then merged in order
+    void load(const char *filename, size_t chunkSize = defaultChunkSize);
     void debug();
 
     static void debug(std::vector<glm::uvec3> &triangles, std::vector<glm::vec4> &vertexes, std::vector<glm::vec2> &uvs, std::vector<glm::vec3> &normals, std::vector<unsigned int> &indexes);
 
+    static const size_t defaultChunkSize = 1 << 20;
+
 private:
 
-    bool openFile(const char *filename, std::ifstream &fin);
-    void parseLines(std::ifstream &fin);
-    void parseVertex(std::ifstream &fin);
-    void parseUVs(std::ifstream &fin);
-    void parseNormal(std::ifstream &fin);
-    void parseFace(std::ifstream &fin);
-    void skipNextChar(std::ifstream &fin);
-    void skipLine(std::ifstream &fin);
-    void addPoint(unsigned int values[3]);
-    void addTriangle(unsigned int values[3]);
+    // What a chunk of lines holds. Face points, 3 per triangle, are 1 based
+    // v/vt/vn indexes, 0 when missing. Bits of w mark the indexes counted
+    // from the chunk's start rather than the file's
+    struct Chunk
+    {
+        std::vector<glm::vec4> vertexes;
+        std::vector<glm::vec2> uvs;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::ivec4> points;
+    };
+
+    static void parseChunk(const char *begin, const char *end, Chunk &chunk);
+    void merge(std::vector<Chunk> &chunks);
 
     std::vector<glm::uvec3> &triangles;
     std::vector<glm::vec4> &vertexes;
     std::vector<glm::vec2> &uvs;
     std::vector<glm::vec3> &normals;
     std::vector<unsigned int> &indexes;
-
-    std::vector<glm::vec3> normalList;
-    std::vector<glm::vec2> uvList;
-
-    const char * VT = "vt";
-    const char * VN = "vn";
-    const char * V = "v";
-    const char * F = "f";
+    std::vector<unsigned int> &positions;
+    size_t positionCount = 0;
 };
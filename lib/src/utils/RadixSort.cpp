@@ -0,0 +1,44 @@
+#include "RadixSort.hpp"
+#include <assert.h>
+
+using namespace std;
+
+void RadixSort::sort(vector<uint64_t>& keys, vector<unsigned int>& values)
+{
+    assert(keys.size() == values.size());
+
+    const size_t size = keys.size();
+    keysBuffer.resize(size);
+    valuesBuffer.resize(size);
+
+    // All the histograms are gathered in one read of the keys
+    size_t counts[8][256] = {};
+    for (size_t i = 0; i < size; i ++) {
+        uint64_t key = keys[i];
+        for (unsigned int pass = 0; pass < 8; pass ++) {
+            counts[pass][(key >> (pass * 8)) & 0xFF] ++;
+        }
+    }
+
+    for (unsigned int pass = 0; pass < 8; pass ++) {
+        const unsigned int shift = pass * 8;
+
+        if (size == 0 || counts[pass][(keys[0] >> shift) & 0xFF] == size) continue;
+
+        size_t offsets[256];
+        size_t offset = 0;
+        for (unsigned int b = 0; b < 256; b ++) {
+            offsets[b] = offset;
+            offset += counts[pass][b];
+        }
+
+        for (size_t i = 0; i < size; i ++) {
+            size_t destination = offsets[(keys[i] >> shift) & 0xFF] ++;
+            keysBuffer[destination] = keys[i];
+            valuesBuffer[destination] = values[i];
+        }
+
+        keys.swap(keysBuffer);
+        values.swap(valuesBuffer);
+    }
+}
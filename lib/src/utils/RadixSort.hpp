@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Stable LSD radix sort of 64 bits keys, 8 bits per pass. The values are moved
+// along with their keys. Passes where every key has the same byte are skipped.
+class RadixSort
+{
+
+public:
+
+    void sort(std::vector<uint64_t>& keys, std::vector<unsigned int>& values);
+
+private:
+
+    std::vector<uint64_t> keysBuffer;
+    std::vector<unsigned int> valuesBuffer;
+};
@@ -0,0 +1,49 @@
+#include "ShadowCascades.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+using namespace glm;
+
+void splitShadowCascades(float near, float far, unsigned int count, float lambda, float* ends)
+{
+    for (unsigned int i = 1; i <= count; i ++) {
+        const float part = float(i) / float(count);
+        const float logarithmic = near * pow(far / near, part);
+        const float uniform = near + (far - near) * part;
+        ends[i - 1] = lambda * logarithmic + (1.f - lambda) * uniform;
+    }
+    ends[count - 1] = far;
+}
+
+ShadowCascade fitShadowCascade(const mat4& view, const mat4& projection, float begin, float end, const vec3& lightDirection, unsigned int resolution)
+{
+    // The slice's corners are at (+-x, +-y) * depth, its smallest bounding
+    // sphere is centered on the view axis where the near and far corners are
+    // equally far, or on the far rectangle when that is behind it
+    const float x = 1.f / projection[0][0];
+    const float y = 1.f / projection[1][1];
+    const float spread = x * x + y * y;
+    const float center = std::min(end, (begin + end) * 0.5f * (1.f + spread));
+    const float radius = sqrt(std::max(
+        (end - center) * (end - center) + end * end * spread,
+        (center - begin) * (center - begin) + begin * begin * spread));
+
+    // The light's rotation alone doesn't depend on the camera, the sphere is
+    // moved on its texel grid
+    const vec3 up = std::abs(lightDirection.z) < 0.99f ? vec3(0.f, 0.f, 1.f) : vec3(0.f, 1.f, 0.f);
+    const mat4 light = lookAt(vec3(0.f), lightDirection, up);
+    const vec4 world = inverse(view) * vec4(0.f, 0.f, -center, 1.f);
+    vec3 origin(light * world);
+
+    ShadowCascade cascade;
+    cascade.texelSize = radius * 2.f / float(resolution);
+    origin.x = floor(origin.x / cascade.texelSize) * cascade.texelSize;
+    origin.y = floor(origin.y / cascade.texelSize) * cascade.texelSize;
+
+    // Casters before the near plane are clamped onto it when drawn
+    cascade.viewProjection = ortho(origin.x - radius, origin.x + radius, origin.y - radius, origin.y + radius, -origin.z - radius, -origin.z + radius) * light;
+    cascade.end = end;
+    return cascade;
+}
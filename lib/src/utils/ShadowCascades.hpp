@@ -0,0 +1,20 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// Shadow map of a directional light covering one depth slice of the view
+struct ShadowCascade
+{
+    glm::mat4 viewProjection; // World to the shadow map, depth clamped before its near plane
+    float end = 0.f;          // View depth where the slice stops
+    float texelSize = 0.f;    // World size of a shadow map texel
+};
+
+// Split the view depths between near and far in count slices, writing where
+// each ends. lambda blends the uniform (0) and logarithmic (1) distributions
+void splitShadowCascades(float near, float far, unsigned int count, float lambda, float* ends);
+
+// Fit a cascade around the slice of the view frustum between the depths
+// begin and end. The slice is bounded by a sphere so the cascade keeps its
+// size as the camera turns, and the sphere is snapped to whole texels in
+// light space so the shadow edges don't shimmer as the camera moves
+ShadowCascade fitShadowCascade(const glm::mat4& view, const glm::mat4& projection, float begin, float end, const glm::vec3& lightDirection, unsigned int resolution);
@@ -0,0 +1,44 @@
+#include "ShadowCulling.hpp"
+#include <algorithm>
+
+using namespace std;
+using namespace glm;
+
+ShadowVolumeTest classifyShadowCaster(const vec4 frustumPlanes[6], const vec3& camera, float cameraRadius, const vec3& center, float radius, const vec3& lightDirection)
+{
+    // Sweeping along the light only gets the sphere away from the planes the
+    // light leaves, it is culled when fully behind one of those
+    for (unsigned int i = 0; i < 6; i ++) {
+        const vec3 normal(frustumPlanes[i]);
+        if (normal == vec3(0.f)) continue;
+        if (dot(normal, lightDirection) <= 0.f && dot(normal, center) + frustumPlanes[i].w < -radius) return SHADOW_CULLED;
+    }
+
+    // Distance from the camera to the half line the sphere is swept along
+    const vec3 offset = camera - center;
+    const float along = dot(offset, lightDirection);
+    const float distanceSquared = along > 0.f ? dot(offset, offset) - along * along : dot(offset, offset);
+    const float reach = radius + cameraRadius;
+    return distanceSquared <= reach * reach ? SHADOW_Z_FAIL : SHADOW_Z_PASS;
+}
+
+bool projectShadowVolume(const mat4& viewProjection, const vec3& center, float radius, const vec3& lightDirection, vec4& bounds)
+{
+    // The volume is within the hull of the sphere's box and of the point at
+    // infinity along the light, projecting keeps lines as long as they stay
+    // in front of the camera
+    bounds = vec4(1e30f, 1e30f, -1e30f, -1e30f);
+    for (unsigned int corner = 0; corner < 9; corner ++) {
+        vec4 point(lightDirection, 0.f);
+        if (corner < 8) {
+            point = vec4(center + radius * vec3(corner & 1 ? 1.f : -1.f, corner & 2 ? 1.f : -1.f, corner & 4 ? 1.f : -1.f), 1.f);
+        }
+        const vec4 clip = viewProjection * point;
+        if (clip.w <= 1e-6f) return false;
+        bounds.x = std::min(bounds.x, clip.x / clip.w);
+        bounds.y = std::min(bounds.y, clip.y / clip.w);
+        bounds.z = std::max(bounds.z, clip.x / clip.w);
+        bounds.w = std::max(bounds.w, clip.y / clip.w);
+    }
+    return true;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// How the shadow volume of a caster lit by a directional light is drawn
+enum ShadowVolumeTest
+{
+    SHADOW_CULLED, // The volume can't reach the view frustum
+    SHADOW_Z_PASS,
+    SHADOW_Z_FAIL  // The near plane may cut the volume, it needs a cap
+};
+
+// Classify a caster bounded by a sphere, its volume being that sphere swept
+// to infinity along the light. Planes point inside the frustum and are
+// normalized, zero ones (the far plane of an infinite projection) are ignored.
+// cameraRadius bounds the near plane rectangle around the camera
+ShadowVolumeTest classifyShadowCaster(const glm::vec4 frustumPlanes[6], const glm::vec3& camera, float cameraRadius, const glm::vec3& center, float radius, const glm::vec3& lightDirection);
+
+// Normalized device bounds (min x, min y, max x, max y) of the same volume on
+// screen, false when it reaches behind the camera and can cover all of it
+bool projectShadowVolume(const glm::mat4& viewProjection, const glm::vec3& center, float radius, const glm::vec3& lightDirection, glm::vec4& bounds);
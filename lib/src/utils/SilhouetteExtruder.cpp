@@ -0,0 +1,97 @@
+#include "SilhouetteExtruder.hpp"
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+using namespace std;
+using namespace glm;
+
+namespace
+{
+    // Same winding as the geometry shader's GetNormal, left unnormalized
+    vec3 normal(const vec4& a, const vec4& b, const vec4& c)
+    {
+        return cross(vec3(a - b), vec3(c - b));
+    }
+
+    // Bit 0 when the triangle faces the light, bit 1 + i when the neighbor
+    // across its edge i does. Facing is !(dot > 0) like in the shader
+    unsigned int facing(const float* normals, const vec3& light)
+    {
+#if defined(__SSE__)
+        const __m128 dots = _mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(_mm_loadu_ps(normals), _mm_set1_ps(light.x)),
+            _mm_mul_ps(_mm_loadu_ps(normals + 4), _mm_set1_ps(light.y))),
+            _mm_mul_ps(_mm_loadu_ps(normals + 8), _mm_set1_ps(light.z)));
+        return unsigned(~_mm_movemask_ps(_mm_cmpgt_ps(dots, _mm_setzero_ps()))) & 0xf;
+#else
+        unsigned int bits = 0;
+        for (unsigned int lane = 0; lane < 4; lane ++) {
+            const float d = normals[lane] * light.x + normals[4 + lane] * light.y + normals[8 + lane] * light.z;
+            if (!(d > 0.f)) bits |= 1u << lane;
+        }
+        return bits;
+#endif
+    }
+}
+
+void prepareShadowCaster(Span<vec4> positions, Span<unsigned int> adjacencyIndexes, ShadowCaster& caster)
+{
+    const size_t triangles = adjacencyIndexes.size() / 6;
+    caster.normals.resize(triangles * 12);
+    caster.corners.resize(triangles * 3);
+
+    for (size_t t = 0; t < triangles; t ++) {
+        const unsigned int* a = adjacencyIndexes.data() + t * 6;
+        vec3 normals[4];
+        normals[0] = normal(positions[a[0]], positions[a[2]], positions[a[4]]);
+        for (unsigned int i = 0; i < 3; i ++) {
+            normals[1 + i] = normal(positions[a[(i * 2 + 2) % 6]], positions[a[i * 2 + 1]], positions[a[i * 2]]);
+            caster.corners[t * 3 + i] = positions[a[i * 2]];
+        }
+        for (unsigned int lane = 0; lane < 4; lane ++) {
+            caster.normals[t * 12 + lane] = normals[lane].x;
+            caster.normals[t * 12 + 4 + lane] = normals[lane].y;
+            caster.normals[t * 12 + 8 + lane] = normals[lane].z;
+        }
+    }
+}
+
+void extrudeSilhouette(const ShadowCaster& caster, const float* matrix, const vec3& lightDirection, vector<vec4>& vertexes, bool caps)
+{
+    // World normals are the adjugate's transpose times the model normals, so
+    // testing them against the light is testing the model normals against
+    // the light taken back by the adjugate, which works for any scale
+    const vec3 r0(matrix[0], matrix[1], matrix[2]);
+    const vec3 r1(matrix[4], matrix[5], matrix[6]);
+    const vec3 r2(matrix[8], matrix[9], matrix[10]);
+    const vec3 light = lightDirection.x * cross(r1, r2) + lightDirection.y * cross(r2, r0) + lightDirection.z * cross(r0, r1);
+
+    const vec4 infinity(lightDirection, 0.f);
+    const size_t triangles = caster.corners.size() / 3;
+
+    for (size_t t = 0; t < triangles; t ++) {
+        const unsigned int bits = facing(caster.normals.data() + t * 12, light);
+        if (!(bits & 1) || (bits == 1 && !caps)) continue;
+
+        const vec4* corners = caster.corners.data() + t * 3;
+        vec4 world[3];
+        for (unsigned int i = 0; i < 3; i ++) {
+            const vec3 corner(corners[i]);
+            world[i] = vec4(dot(r0, corner) + matrix[3], dot(r1, corner) + matrix[7], dot(r2, corner) + matrix[11], 1.f);
+        }
+
+        for (unsigned int i = 0; i < 3; i ++) {
+            if (!(bits & (2u << i))) continue;
+            vertexes.push_back(world[(i + 1) % 3]);
+            vertexes.push_back(infinity);
+            vertexes.push_back(world[i]);
+        }
+        if (caps) {
+            vertexes.push_back(world[0]);
+            vertexes.push_back(world[2]);
+            vertexes.push_back(world[1]);
+        }
+    }
+}
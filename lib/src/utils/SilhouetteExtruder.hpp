@@ -0,0 +1,26 @@
+#pragma once
+#include "Span.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+
+// What the shadow volume geometry shader needs from a mesh, laid out for the
+// CPU: the corners of each triangle and the normals it tests against the light
+struct ShadowCaster
+{
+    // 12 floats per triangle: the x, then y, then z of the normals of the
+    // triangle and of its 3 neighbors, one per lane
+    std::vector<float> normals;
+    // 3 per triangle
+    std::vector<glm::vec4> corners;
+};
+
+// Build the caster of a mesh from its GL_TRIANGLES_ADJACENCY indexes
+void prepareShadowCaster(Span<glm::vec4> positions, Span<unsigned int> adjacencyIndexes, ShadowCaster& caster);
+
+// Append the sides of an instance's shadow volume, as the geometry shader does:
+// one triangle per silhouette edge, from its two ends to the point at infinity
+// the light goes to. matrix is the instance's row major 3x4 transform and the
+// vertexes are in world space. With caps, the triangles the sides start from
+// are added too, reversed so the volume is closed for z-fail stencil tests
+// (its far end is the point at infinity)
+void extrudeSilhouette(const ShadowCaster& caster, const float* matrix, const glm::vec3& lightDirection, std::vector<glm::vec4>& vertexes, bool caps = false);
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Read only view of items stored elsewhere, a vector or a mapped file
+template <typename T>
+class Span
+{
+
+public:
+
+    Span() {}
+    Span(const T* items, size_t count) : items(items), count(count) {}
+    Span(const std::vector<T>& items) : items(items.data()), count(items.size()) {}
+
+    const T* data() const { return items; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T& operator[](size_t i) const { return items[i]; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+
+private:
+
+    const T* items = nullptr;
+    size_t count = 0;
+};
@@ -14,6 +14,15 @@ class Store
 public:
 
     void insert(K key, A arguments);
+    // Take an item built elsewhere, by a loading thread for instance. It
+    // fills the key's slot if it was reserved
+    void insert(K key, C* item);
+    // Give the key an id before its item exists, the slot stays empty until inserted
+    unsigned int reserve(K key);
+    // Swap the item of an id for a new one, the id stays the same
+    void replace(unsigned int id, C* item);
+
+    unsigned int size() const;
 
     unsigned int getId(K key);
 
@@ -37,6 +46,42 @@ void Store<K, C, A>::insert(K key, A arguments)
     }
 }
 
+template <typename K, typename C, typename A>
+void Store<K, C, A>::insert(K key, C* item)
+{
+    int id = findId(key);
+    if (id == -1) {
+        ids.push_back(std::make_pair(key, items.size()));
+        items.emplace_back(item);
+    } else if (!items[static_cast<unsigned int>(id)]) {
+        items[static_cast<unsigned int>(id)].reset(item);
+    } else {
+        delete item;
+    }
+}
+
+template <typename K, typename C, typename A>
+unsigned int Store<K, C, A>::reserve(K key)
+{
+    if (findId(key) == -1) {
+        ids.push_back(std::make_pair(key, items.size()));
+        items.emplace_back(nullptr);
+    }
+    return getId(key);
+}
+
+template <typename K, typename C, typename A>
+void Store<K, C, A>::replace(unsigned int id, C* item)
+{
+    items.at(id).reset(item);
+}
+
+template <typename K, typename C, typename A>
+unsigned int Store<K, C, A>::size() const
+{
+    return static_cast<unsigned int>(items.size());
+}
+
 template <typename K, typename C, typename A>
 int Store<K, C, A>::findId(K key)
 {
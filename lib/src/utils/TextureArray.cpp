@@ -0,0 +1,75 @@
+#include "TextureArray.hpp"
+#include "TextureCooker.hpp"
+#include "../graphic/GLState.hpp"
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+TextureArray::~TextureArray()
+{
+    destroy();
+}
+
+void TextureArray::allocate(GLsizei _width, GLsizei _height, GLsizei _layers, bool color)
+{
+    destroy();
+
+    width = _width;
+    height = _height;
+    layers = _layers;
+
+    glGenTextures(1, &id);
+    glState().bindTexture(GL_TEXTURE0, GL_TEXTURE_2D_ARRAY, id);
+
+    // Every level is allocated up front, layers are filled one at a time
+    levels = 0;
+    for (GLsizei w = width, h = height; ; w = max(w / 2, 1), h = max(h / 2, 1)) {
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, levels ++, color ? GL_SRGB : GL_RGB8, w, h, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        if (w == 1 && h == 1) break;
+    }
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+}
+
+void TextureArray::load(GLint layer, const MipChain& chain)
+{
+    glState().bindTexture(GL_TEXTURE0, GL_TEXTURE_2D_ARRAY, id);
+    GLsizei w = width;
+    GLsizei h = height;
+    for (GLint level = 0; level < levels && level < GLint(chain.levels.size()); level ++) {
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, w, h, 1, GL_RGBA, GL_UNSIGNED_BYTE, chain.levels[size_t(level)].data());
+        w = max(w / 2, 1);
+        h = max(h / 2, 1);
+    }
+}
+
+void TextureArray::clear(GLint layer)
+{
+    // Missing textures sample black, like an unbound texture unit
+    MipChain black;
+    for (GLsizei w = width, h = height; black.levels.size() < size_t(levels); w = max(w / 2, 1), h = max(h / 2, 1)) {
+        black.levels.push_back(vector<unsigned char>(size_t(w * h * 4), 0));
+    }
+    load(layer, black);
+}
+
+void TextureArray::bind(GLenum textureUnit)
+{
+    glState().bindTexture(textureUnit, GL_TEXTURE_2D_ARRAY, id);
+}
+
+GLsizei TextureArray::getLayers() const
+{
+    return layers;
+}
+
+void TextureArray::destroy()
+{
+    if (!id) return;
+    glState().deleteTexture(id);
+    id = 0;
+    layers = 0;
+    levels = 0;
+}
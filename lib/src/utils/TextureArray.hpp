@@ -0,0 +1,34 @@
+#pragma once
+#include <OpenGL.hpp>
+
+struct MipChain;
+
+// Same sized RGBA textures stored as the layers of one GL_TEXTURE_2D_ARRAY,
+// a shader picks the layer so drawing with another texture needs no bind.
+class TextureArray
+{
+
+public:
+
+    ~TextureArray();
+
+    // Reallocate room for layers of width * height texels, previous layers are lost.
+    // Colors are sRGB, other data is stored as it is
+    void allocate(GLsizei width, GLsizei height, GLsizei layers, bool color = true);
+    // Fill the layer's levels with the chain's, it must be a full chain of the array's size
+    void load(GLint layer, const MipChain& chain);
+    void clear(GLint layer);
+    void bind(GLenum textureUnit);
+
+    GLsizei getLayers() const;
+
+private:
+
+    void destroy();
+
+    GLuint id = 0;
+    GLsizei width = 0;
+    GLsizei height = 0;
+    GLsizei layers = 0;
+    GLint levels = 0;
+};
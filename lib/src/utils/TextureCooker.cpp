@@ -0,0 +1,177 @@
+#include "TextureCooker.hpp"
+#include "Hash.hpp"
+#include "Log.hpp"
+#include "lodepng.h"
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+using namespace std;
+
+namespace
+{
+    const char magic[4] {'T', 'W', 'T', 'X'};
+    const uint32_t version = 1;
+
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t source;
+        uint32_t width;
+        uint32_t height;
+        uint32_t levels;
+        uint32_t padding;
+    };
+
+    bool readFile(const string& filename, vector<unsigned char>& bytes)
+    {
+        ifstream file(filename, ios::binary | ios::ate);
+        if (!file) return false;
+        bytes.resize(size_t(file.tellg()));
+        file.seekg(0);
+        return bool(file.read(reinterpret_cast<char*>(bytes.data()), streamsize(bytes.size())));
+    }
+
+    size_t levelSize(unsigned int width, unsigned int height, unsigned int level)
+    {
+        return size_t(max(width >> level, 1u)) * max(height >> level, 1u) * 4;
+    }
+
+    bool readCooked(const string& filename, uint64_t source, MipChain& chain)
+    {
+        vector<unsigned char> bytes;
+        if (!readFile(filename, bytes) || bytes.size() < sizeof(Header)) return false;
+
+        Header header;
+        memcpy(&header, bytes.data(), sizeof(Header));
+        if (memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version || header.source != source) return false;
+
+        size_t offset = sizeof(Header);
+        chain.width = header.width;
+        chain.height = header.height;
+        chain.levels.resize(header.levels);
+        for (unsigned int level = 0; level < header.levels; level ++) {
+            const size_t size = levelSize(header.width, header.height, level);
+            if (offset + size > bytes.size()) return false;
+            chain.levels[level].assign(bytes.begin() + long(offset), bytes.begin() + long(offset + size));
+            offset += size;
+        }
+        return true;
+    }
+
+    void writeCooked(const string& filename, uint64_t source, const MipChain& chain)
+    {
+        Header header {};
+        memcpy(header.magic, magic, sizeof(magic));
+        header.version = version;
+        header.source = source;
+        header.width = chain.width;
+        header.height = chain.height;
+        header.levels = uint32_t(chain.levels.size());
+
+        // Written aside then renamed, textures are cooked in parallel and a
+        // reader must never see a partial copy. Each thread writes its own
+        const string written = filename + "." + to_string(hash<thread::id>()(this_thread::get_id())) + ".tmp";
+        ofstream file(written, ios::binary | ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        for (auto& level : chain.levels) {
+            file.write(reinterpret_cast<const char*>(level.data()), streamsize(level.size()));
+        }
+        file.close();
+        if (!file || rename(written.c_str(), filename.c_str()) != 0) {
+            warning("TextureCooker: could not write", filename);
+            remove(written.c_str());
+        }
+    }
+
+    float toLinear(unsigned char c)
+    {
+        const float f = c / 255.f;
+        return f <= 0.04045f ? f / 12.92f : pow((f + 0.055f) / 1.055f, 2.4f);
+    }
+
+    unsigned char toSRGB(float l)
+    {
+        const float f = l <= 0.0031308f ? l * 12.92f : 1.055f * pow(l, 1.f / 2.4f) - 0.055f;
+        return static_cast<unsigned char>(min(max(f, 0.f), 1.f) * 255.f + 0.5f);
+    }
+}
+
+void generateMipChain(MipChain& chain, bool color)
+{
+    float linear[256];
+    for (unsigned int c = 0; c < 256; c ++) {
+        linear[c] = toLinear(static_cast<unsigned char>(c));
+    }
+
+    chain.levels.resize(1);
+    unsigned int width = chain.width;
+    unsigned int height = chain.height;
+
+    // Box filter of the 2x2 texels above, an odd last row or column is repeated
+    while (width > 1 || height > 1) {
+        const unsigned int w = max(width / 2, 1u);
+        const unsigned int h = max(height / 2, 1u);
+        const vector<unsigned char>& source = chain.levels.back();
+        vector<unsigned char> level(size_t(w) * h * 4);
+
+        for (unsigned int y = 0; y < h; y ++) {
+            const unsigned int y0 = min(y * 2, height - 1);
+            const unsigned int y1 = min(y * 2 + 1, height - 1);
+            for (unsigned int x = 0; x < w; x ++) {
+                const unsigned int x0 = min(x * 2, width - 1);
+                const unsigned int x1 = min(x * 2 + 1, width - 1);
+                const unsigned char* texels[4] {
+                    &source[(size_t(y0) * width + x0) * 4],
+                    &source[(size_t(y0) * width + x1) * 4],
+                    &source[(size_t(y1) * width + x0) * 4],
+                    &source[(size_t(y1) * width + x1) * 4]
+                };
+                unsigned char* texel = &level[(size_t(y) * w + x) * 4];
+                for (unsigned int c = 0; c < 4; c ++) {
+                    if (color && c < 3) {
+                        texel[c] = toSRGB((linear[texels[0][c]] + linear[texels[1][c]] + linear[texels[2][c]] + linear[texels[3][c]]) * 0.25f);
+                    } else {
+                        texel[c] = static_cast<unsigned char>((texels[0][c] + texels[1][c] + texels[2][c] + texels[3][c] + 2) / 4);
+                    }
+                }
+            }
+        }
+
+        chain.levels.push_back(level);
+        width = w;
+        height = h;
+    }
+}
+
+bool loadCooked(const char* filename, MipChain& chain, bool mipmaps, bool color)
+{
+    vector<unsigned char> png;
+    if (!readFile(filename, png)) {
+        error("TextureCooker: could not read", filename);
+        return false;
+    }
+
+    // Cooked copies are keyed by the content they were made from
+    const bool options[2] {mipmaps, color};
+    const uint64_t source = fnv1a(options, sizeof(options), fnv1a(png.data(), png.size()));
+    // Each set of options has its own copy, so loaders asking for different ones don't overwrite each other's
+    const string cooked = string(filename) + (color ? "" : ".linear") + (mipmaps ? "" : ".base") + ".cooked";
+    if (readCooked(cooked, source, chain)) return true;
+
+    chain.levels.assign(1, vector<unsigned char>());
+    unsigned e = lodepng::decode(chain.levels[0], chain.width, chain.height, png);
+    if (e) {
+        error("TextureCooker:", lodepng_error_text(e), filename);
+        return false;
+    }
+    if (mipmaps) generateMipChain(chain, color);
+
+    writeCooked(cooked, source, chain);
+    success("TextureCooker: cooked", filename);
+    return true;
+}
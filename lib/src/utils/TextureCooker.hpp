@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// RGBA pixels of a texture and of its mip levels, from the full size down to 1x1
+struct MipChain
+{
+    unsigned int width = 0;
+    unsigned int height = 0;
+    std::vector<std::vector<unsigned char>> levels;
+};
+
+// Load a PNG from its cooked copy, filename.cooked, read at once and ready to
+// upload. Data textures are cooked in filename.linear.cooked and textures
+// without mip levels in filename.base.cooked. The copy is cooked again when
+// missing or made from other content. Return false when the PNG can't be decoded
+bool loadCooked(const char* filename, MipChain& chain, bool mipmaps, bool color = true);
+
+// Append the levels below the first one. Colors are sRGB, they are averaged in
+// linear space, other data (normals, metallicness, roughness) as it is
+void generateMipChain(MipChain& chain, bool color = true);
@@ -0,0 +1,108 @@
+#include "ThreadPool.hpp"
+
+using namespace std;
+
+ThreadPool::ThreadPool(unsigned int threads)
+{
+    // hardware_concurrency may not know
+    if (threads == 0) threads = 1;
+    for (unsigned int i = 0; i < threads; i ++) {
+        workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queued.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::enqueue(function<void()> task, Priority priority, Group* group)
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        tasks[priority].push_back({move(task), group});
+        waiting ++;
+        if (group) group->pending ++;
+    }
+    queued.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this]() { return waiting == 0 && running == 0; });
+}
+
+void ThreadPool::wait(Group& group)
+{
+    unique_lock<std::mutex> lock(mutex);
+    while (group.pending > 0) {
+        Task task {nullptr, nullptr};
+        for (auto& queue : tasks) {
+            for (auto t = queue.begin(); t != queue.end(); t ++) {
+                if (t->group != &group) continue;
+                task = move(*t);
+                queue.erase(t);
+                break;
+            }
+            if (task.run) break;
+        }
+
+        // The rest of the group is running on the workers
+        if (!task.run) {
+            finished.wait(lock);
+            continue;
+        }
+        waiting --;
+        run(task, lock);
+    }
+}
+
+unsigned int ThreadPool::size() const
+{
+    return unsigned(workers.size());
+}
+
+void ThreadPool::work()
+{
+    unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        queued.wait(lock, [this]() { return stopping || waiting > 0; });
+        if (stopping) return;
+
+        for (auto& queue : tasks) {
+            if (queue.empty()) continue;
+            Task task = move(queue.front());
+            queue.pop_front();
+            waiting --;
+            run(task, lock);
+            break;
+        }
+    }
+}
+
+void ThreadPool::run(Task& task, unique_lock<std::mutex>& lock)
+{
+    running ++;
+    lock.unlock();
+
+    task.run();
+
+    lock.lock();
+    running --;
+    if (task.group) task.group->pending --;
+    finished.notify_all();
+}
+
+ThreadPool& threadPool()
+{
+    static ThreadPool pool(thread::hardware_concurrency() > 1 ? thread::hardware_concurrency() - 1 : 1);
+    return pool;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running queued tasks, the most urgent first.
+// Tasks must not touch the GL context, it only belongs to the thread that
+// created it.
+class ThreadPool
+{
+
+public:
+
+    // Frame work first, then what a load waits for, then background streaming
+    enum Priority { URGENT, NORMAL, BACKGROUND };
+
+    // Tasks waited for together, so users sharing the pool don't wait for each other
+    class Group
+    {
+        friend class ThreadPool;
+        unsigned int pending = 0;
+    };
+
+    explicit ThreadPool(unsigned int threads = std::thread::hardware_concurrency());
+    // Queued tasks are dropped, running ones are finished
+    ~ThreadPool();
+
+    void enqueue(std::function<void()> task, Priority priority = NORMAL, Group* group = nullptr);
+    // Block until every queued task is done
+    void wait();
+    // Block until the group's tasks are done, running those still queued on
+    // this thread meanwhile. Tasks can wait for the groups they queue
+    void wait(Group& group);
+
+    unsigned int size() const;
+
+private:
+
+    struct Task
+    {
+        std::function<void()> run;
+        Group* group;
+    };
+
+    void work();
+    void run(Task& task, std::unique_lock<std::mutex>& lock);
+
+    std::vector<std::thread> workers;
+    std::deque<Task> tasks[3];
+    std::mutex mutex;
+    std::condition_variable queued;
+    std::condition_variable finished;
+    unsigned int waiting = 0;
+    unsigned int running = 0;
+    bool stopping = false;
+};
+
+// Pool shared by every user, one worker per core but the calling thread's,
+// which runs tasks while it waits for them
+ThreadPool& threadPool();
@@ -0,0 +1,266 @@
+#include "Transforms.hpp"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define TRANSFORMS_AVX
+#include <immintrin.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+using namespace glm;
+
+const unsigned int Transforms::matrixFloats;
+
+#if defined(__SSE__)
+namespace
+{
+    // e holds the 12 matrix elements (row major) of 4 instances, one instance per lane
+    inline void storeMatrices(__m128 e[12], float* matrices)
+    {
+        for (unsigned int row = 0; row < 3; row ++) {
+            __m128 c0 = e[row * 4 + 0];
+            __m128 c1 = e[row * 4 + 1];
+            __m128 c2 = e[row * 4 + 2];
+            __m128 c3 = e[row * 4 + 3];
+            _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+            _mm_storeu_ps(matrices + 0 * Transforms::matrixFloats + row * 4, c0);
+            _mm_storeu_ps(matrices + 1 * Transforms::matrixFloats + row * 4, c1);
+            _mm_storeu_ps(matrices + 2 * Transforms::matrixFloats + row * 4, c2);
+            _mm_storeu_ps(matrices + 3 * Transforms::matrixFloats + row * 4, c3);
+        }
+    }
+}
+#endif
+
+void Transforms::add(const vec3& position, const quat& orientation, const vec3& scale)
+{
+    positionsX.push_back(position.x);
+    positionsY.push_back(position.y);
+    positionsZ.push_back(position.z);
+    orientationsX.push_back(orientation.x);
+    orientationsY.push_back(orientation.y);
+    orientationsZ.push_back(orientation.z);
+    orientationsW.push_back(orientation.w);
+    scalesX.push_back(scale.x);
+    scalesY.push_back(scale.y);
+    scalesZ.push_back(scale.z);
+}
+
+void Transforms::clear()
+{
+    positionsX.clear();
+    positionsY.clear();
+    positionsZ.clear();
+    orientationsX.clear();
+    orientationsY.clear();
+    orientationsZ.clear();
+    orientationsW.clear();
+    scalesX.clear();
+    scalesY.clear();
+    scalesZ.clear();
+}
+
+void Transforms::gather(const Transforms& source, const std::vector<unsigned int>& order)
+{
+    clear();
+    for (auto i : order) {
+        positionsX.push_back(source.positionsX[i]);
+        positionsY.push_back(source.positionsY[i]);
+        positionsZ.push_back(source.positionsZ[i]);
+        orientationsX.push_back(source.orientationsX[i]);
+        orientationsY.push_back(source.orientationsY[i]);
+        orientationsZ.push_back(source.orientationsZ[i]);
+        orientationsW.push_back(source.orientationsW[i]);
+        scalesX.push_back(source.scalesX[i]);
+        scalesY.push_back(source.scalesY[i]);
+        scalesZ.push_back(source.scalesZ[i]);
+    }
+}
+
+unsigned int Transforms::size() const
+{
+    return unsigned(positionsX.size());
+}
+
+vec3 Transforms::getPosition(unsigned int index) const
+{
+    return vec3(positionsX[index], positionsY[index], positionsZ[index]);
+}
+
+vec3 Transforms::getScale(unsigned int index) const
+{
+    return vec3(scalesX[index], scalesY[index], scalesZ[index]);
+}
+
+bool Transforms::hasAVX()
+{
+#if defined(TRANSFORMS_AVX)
+    static const bool supported = __builtin_cpu_supports("avx");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+void Transforms::compose(float* matrices) const
+{
+    compose(matrices, hasAVX());
+}
+
+void Transforms::compose(float* matrices, bool avx) const
+{
+    unsigned int i = avx ? composeAVX(0, matrices) : 0;
+    i = composeSSE(i, matrices);
+    composeRange(i, size(), matrices);
+}
+
+#if defined(TRANSFORMS_AVX)
+__attribute__((target("avx")))
+#endif
+unsigned int Transforms::composeAVX(unsigned int begin, float* matrices) const
+{
+    unsigned int i = begin;
+#if defined(TRANSFORMS_AVX)
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 two = _mm256_set1_ps(2.f);
+    for (; i + 8 <= size(); i += 8) {
+        const __m256 x = _mm256_loadu_ps(&orientationsX[i]);
+        const __m256 y = _mm256_loadu_ps(&orientationsY[i]);
+        const __m256 z = _mm256_loadu_ps(&orientationsZ[i]);
+        const __m256 w = _mm256_loadu_ps(&orientationsW[i]);
+        const __m256 sx = _mm256_loadu_ps(&scalesX[i]);
+        const __m256 sy = _mm256_loadu_ps(&scalesY[i]);
+        const __m256 sz = _mm256_loadu_ps(&scalesZ[i]);
+
+        const __m256 x2 = _mm256_mul_ps(x, two);
+        const __m256 y2 = _mm256_mul_ps(y, two);
+        const __m256 z2 = _mm256_mul_ps(z, two);
+        const __m256 xx = _mm256_mul_ps(x, x2);
+        const __m256 yy = _mm256_mul_ps(y, y2);
+        const __m256 zz = _mm256_mul_ps(z, z2);
+        const __m256 xy = _mm256_mul_ps(x, y2);
+        const __m256 xz = _mm256_mul_ps(x, z2);
+        const __m256 yz = _mm256_mul_ps(y, z2);
+        const __m256 wx = _mm256_mul_ps(w, x2);
+        const __m256 wy = _mm256_mul_ps(w, y2);
+        const __m256 wz = _mm256_mul_ps(w, z2);
+
+        const __m256 e[12] = {
+            _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx),
+            _mm256_mul_ps(_mm256_sub_ps(xy, wz), sy),
+            _mm256_mul_ps(_mm256_add_ps(xz, wy), sz),
+            _mm256_loadu_ps(&positionsX[i]),
+            _mm256_mul_ps(_mm256_add_ps(xy, wz), sx),
+            _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy),
+            _mm256_mul_ps(_mm256_sub_ps(yz, wx), sz),
+            _mm256_loadu_ps(&positionsY[i]),
+            _mm256_mul_ps(_mm256_sub_ps(xz, wy), sx),
+            _mm256_mul_ps(_mm256_add_ps(yz, wx), sy),
+            _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz),
+            _mm256_loadu_ps(&positionsZ[i])
+        };
+
+        __m128 low[12];
+        __m128 high[12];
+        for (unsigned int j = 0; j < 12; j ++) {
+            low[j] = _mm256_castps256_ps128(e[j]);
+            high[j] = _mm256_extractf128_ps(e[j], 1);
+        }
+        storeMatrices(low, matrices + i * matrixFloats);
+        storeMatrices(high, matrices + (i + 4) * matrixFloats);
+    }
+#else
+    (void)matrices;
+#endif
+    return i;
+}
+
+unsigned int Transforms::composeSSE(unsigned int begin, float* matrices) const
+{
+    unsigned int i = begin;
+#if defined(__SSE__)
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 two = _mm_set1_ps(2.f);
+    for (; i + 4 <= size(); i += 4) {
+        const __m128 x = _mm_loadu_ps(&orientationsX[i]);
+        const __m128 y = _mm_loadu_ps(&orientationsY[i]);
+        const __m128 z = _mm_loadu_ps(&orientationsZ[i]);
+        const __m128 w = _mm_loadu_ps(&orientationsW[i]);
+        const __m128 sx = _mm_loadu_ps(&scalesX[i]);
+        const __m128 sy = _mm_loadu_ps(&scalesY[i]);
+        const __m128 sz = _mm_loadu_ps(&scalesZ[i]);
+
+        const __m128 x2 = _mm_mul_ps(x, two);
+        const __m128 y2 = _mm_mul_ps(y, two);
+        const __m128 z2 = _mm_mul_ps(z, two);
+        const __m128 xx = _mm_mul_ps(x, x2);
+        const __m128 yy = _mm_mul_ps(y, y2);
+        const __m128 zz = _mm_mul_ps(z, z2);
+        const __m128 xy = _mm_mul_ps(x, y2);
+        const __m128 xz = _mm_mul_ps(x, z2);
+        const __m128 yz = _mm_mul_ps(y, z2);
+        const __m128 wx = _mm_mul_ps(w, x2);
+        const __m128 wy = _mm_mul_ps(w, y2);
+        const __m128 wz = _mm_mul_ps(w, z2);
+
+        __m128 e[12] = {
+            _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx),
+            _mm_mul_ps(_mm_sub_ps(xy, wz), sy),
+            _mm_mul_ps(_mm_add_ps(xz, wy), sz),
+            _mm_loadu_ps(&positionsX[i]),
+            _mm_mul_ps(_mm_add_ps(xy, wz), sx),
+            _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy),
+            _mm_mul_ps(_mm_sub_ps(yz, wx), sz),
+            _mm_loadu_ps(&positionsY[i]),
+            _mm_mul_ps(_mm_sub_ps(xz, wy), sx),
+            _mm_mul_ps(_mm_add_ps(yz, wx), sy),
+            _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz),
+            _mm_loadu_ps(&positionsZ[i])
+        };
+
+        storeMatrices(e, matrices + i * matrixFloats);
+    }
+#else
+    (void)matrices;
+#endif
+    return i;
+}
+
+void Transforms::composeScalar(float* matrices) const
+{
+    composeRange(0, size(), matrices);
+}
+
+void Transforms::composeRange(unsigned int begin, unsigned int end, float* matrices) const
+{
+    for (unsigned int i = begin; i < end; i ++) {
+        const float x = orientationsX[i];
+        const float y = orientationsY[i];
+        const float z = orientationsZ[i];
+        const float w = orientationsW[i];
+
+        const float xx = 2.f * x * x;
+        const float yy = 2.f * y * y;
+        const float zz = 2.f * z * z;
+        const float xy = 2.f * x * y;
+        const float xz = 2.f * x * z;
+        const float yz = 2.f * y * z;
+        const float wx = 2.f * w * x;
+        const float wy = 2.f * w * y;
+        const float wz = 2.f * w * z;
+
+        float* m = matrices + i * matrixFloats;
+        m[0]  = (1.f - (yy + zz)) * scalesX[i];
+        m[1]  = (xy - wz) * scalesY[i];
+        m[2]  = (xz + wy) * scalesZ[i];
+        m[3]  = positionsX[i];
+        m[4]  = (xy + wz) * scalesX[i];
+        m[5]  = (1.f - (xx + zz)) * scalesY[i];
+        m[6]  = (yz - wx) * scalesZ[i];
+        m[7]  = positionsY[i];
+        m[8]  = (xz - wy) * scalesX[i];
+        m[9]  = (yz + wx) * scalesY[i];
+        m[10] = (1.f - (xx + yy)) * scalesZ[i];
+        m[11] = positionsZ[i];
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+
+// Instances' transformations of a mesh stored as a structure of arrays so they
+// can be composed several at a time with SIMD instructions.
+class Transforms
+{
+
+public:
+
+    // Floats per composed matrix: 3 rows of 4 (the last row is always 0, 0, 0, 1)
+    static const unsigned int matrixFloats = 12;
+
+    void add(const glm::vec3& position, const glm::quat& orientation, const glm::vec3& scale);
+    void clear();
+    // Replace the content with source's transforms, in the given order
+    void gather(const Transforms& source, const std::vector<unsigned int>& order);
+
+    unsigned int size() const;
+    glm::vec3 getPosition(unsigned int index) const;
+    glm::vec3 getScale(unsigned int index) const;
+
+    // Write size() row major 3x4 matrices (translation * rotation * scale),
+    // with AVX when the CPU running it has it
+    void compose(float* matrices) const;
+    // Same with a chosen path, avx must only be asked when supported
+    void compose(float* matrices, bool avx) const;
+    void composeScalar(float* matrices) const;
+
+    // The AVX path is compiled for x86-64 whatever the build flags, and picked at run time
+    static bool hasAVX();
+
+private:
+
+    unsigned int composeAVX(unsigned int begin, float* matrices) const;
+    unsigned int composeSSE(unsigned int begin, float* matrices) const;
+    void composeRange(unsigned int begin, unsigned int end, float* matrices) const;
+
+    std::vector<float> positionsX;
+    std::vector<float> positionsY;
+    std::vector<float> positionsZ;
+    std::vector<float> orientationsX;
+    std::vector<float> orientationsY;
+    std::vector<float> orientationsZ;
+    std::vector<float> orientationsW;
+    std::vector<float> scalesX;
+    std::vector<float> scalesY;
+    std::vector<float> scalesZ;
+};
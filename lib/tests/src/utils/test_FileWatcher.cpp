@@ -0,0 +1,92 @@
+#include "catch.hpp"
+#include "../../../src/utils/FileWatcher.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+#ifdef __linux__
+namespace
+{
+    void write(const string& filename, const string& content)
+    {
+        ofstream file(filename, ios::trunc);
+        file << content;
+    }
+
+    void wait(unsigned int milliseconds)
+    {
+        this_thread::sleep_for(chrono::milliseconds(milliseconds));
+    }
+
+    SCENARIO("FileWatcher reports written files once settled") {
+
+        GIVEN("a watched directory with a subdirectory") {
+
+            char root[] = "/tmp/tinyworld_test_watcherXXXXXX";
+            REQUIRE(mkdtemp(root) != nullptr);
+            const string directory(root);
+            mkdir((directory + "/shaders").c_str(), 0700);
+
+            FileWatcher watcher(directory, 20);
+
+            WHEN("nothing is written") {
+
+                THEN("nothing is reported") {
+
+                    CHECK(watcher.poll().empty());
+                }
+            }
+
+            WHEN("a file of the subdirectory is written twice") {
+
+                write(directory + "/shaders/a.vert", "1");
+                write(directory + "/shaders/a.vert", "2");
+
+                THEN("it is not reported before the debounce delay") {
+
+                    CHECK(watcher.poll().empty());
+                }
+
+                THEN("it is reported once after the debounce delay") {
+
+                    watcher.poll();
+                    wait(50);
+                    vector<string> changes = watcher.poll();
+                    REQUIRE(changes.size() == 1);
+                    CHECK(changes[0] == directory + "/shaders/a.vert");
+                    CHECK(watcher.poll().empty());
+                }
+            }
+
+            WHEN("a file is written in a directory created after watching") {
+
+                mkdir((directory + "/objects").c_str(), 0700);
+                watcher.poll();
+                write(directory + "/objects/cube.obj", "v 0 0 0");
+                watcher.poll();
+                wait(50);
+
+                THEN("it is reported too") {
+
+                    vector<string> changes = watcher.poll();
+                    CHECK(find(changes.begin(), changes.end(), directory + "/objects/cube.obj") != changes.end());
+                }
+            }
+
+            unlink((directory + "/shaders/a.vert").c_str());
+            unlink((directory + "/objects/cube.obj").c_str());
+            rmdir((directory + "/shaders").c_str());
+            rmdir((directory + "/objects").c_str());
+            rmdir(directory.c_str());
+        }
+    }
+}
+#endif
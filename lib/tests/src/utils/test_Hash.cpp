@@ -0,0 +1,39 @@
+#include "catch.hpp"
+#include "../../../src/utils/Hash.hpp"
+#include <string>
+
+using namespace std;
+
+namespace
+{
+    SCENARIO("fnv1a hashes bytes") {
+
+        GIVEN("the reference FNV-1a inputs") {
+
+            THEN("the hashes are the reference ones") {
+
+                CHECK(fnv1a("", 0) == 0xcbf29ce484222325ull);
+                CHECK(fnv1a("a", 1) == 0xaf63dc4c8601ec8cull);
+                CHECK(fnv1a("foobar", 6) == 0x85944171f73967e8ull);
+            }
+        }
+
+        GIVEN("some bytes hashed in two parts") {
+
+            const string bytes = "twisted torus";
+
+            THEN("the hash is the same as at once when the second part is seeded with the first") {
+
+                CHECK(fnv1a(bytes.data() + 7, 6, fnv1a(bytes.data(), 7)) == fnv1a(bytes.data(), bytes.size()));
+            }
+        }
+
+        GIVEN("different bytes") {
+
+            THEN("the hashes are different") {
+
+                CHECK(fnv1a("diffuse.png", 11) != fnv1a("normal.png", 10));
+            }
+        }
+    }
+}
@@ -1,12 +1,67 @@
 #include "catch.hpp"
 #include "../../../src/utils/Manifold.hpp"
+#include "../../../src/utils/Log.hpp"
 #include <glm/glm.hpp>
+#include <chrono>
 
 using namespace std;
 using namespace glm;
 
 namespace
 {
+    // Former implementation, comparing the triangles around each vertex, kept
+    // as the reference of closed meshes and the baseline of the benchmark
+    void referenceAdjacencyIndex(vector<uvec3> &triangles, vector<unsigned int> &indexes)
+    {
+        vector<vector<uvec3*>> indexesTriangles;
+        for (auto& t : triangles) {
+            for (int i = 0; i < 3; ++i) {
+                if (indexesTriangles.size() <= t[i]) indexesTriangles.resize(t[i] + 1, vector<uvec3*>({}));
+                indexesTriangles[t[i]].push_back(&t);
+            }
+        }
+
+        for (auto& t : triangles) {
+            for (int ti = 0; ti < 3; ti ++) {
+                bool matched = false;
+                for (auto& n : indexesTriangles[t[ti]]) {
+                    if (matched) break;
+                    if (*n == t) continue;
+                    for (int ni = 0; ni < 3; ni ++) {
+                        unsigned int t1_A = t[ti];
+                        unsigned int t1_B = t[(ti + 1) % 3];
+                        unsigned int t2_A = (*n)[ni];
+                        unsigned int t2_B = (*n)[(ni + 1) % 3];
+                        if ((t1_A == t2_A && t1_B == t2_B) || (t1_A == t2_B && t1_B == t2_A)) {
+                            indexes.push_back(t[ti]);
+                            indexes.push_back((*n)[(ni + 2) % 3]);
+                            matched = true;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Closed torus of columns * rows quads
+    vector<uvec3> torus(unsigned int columns, unsigned int rows)
+    {
+        vector<uvec3> triangles;
+        triangles.reserve(columns * rows * 2);
+        for (unsigned int y = 0; y < rows; y ++) {
+            for (unsigned int x = 0; x < columns; x ++) {
+                const unsigned int a = y * columns + x;
+                const unsigned int b = y * columns + (x + 1) % columns;
+                const unsigned int c = ((y + 1) % rows) * columns + x;
+                const unsigned int d = ((y + 1) % rows) * columns + (x + 1) % columns;
+                triangles.push_back(uvec3(a, b, c));
+                triangles.push_back(uvec3(b, d, c));
+            }
+        }
+        return triangles;
+    }
+
     SCENARIO("Manifold util can generate triangles adjacency index") {
 
         vector<uvec3> triangles;
@@ -41,5 +96,130 @@ namespace
                 }
             }
         }
+
+        GIVEN("a quad, open on its four sides") {
+
+            triangles.push_back(uvec3(0, 1, 2));
+            triangles.push_back(uvec3(2, 1, 3));
+
+            WHEN("generating triangles adjacency index") {
+
+                generateTrianglesAdjacencyIndex(triangles, indexes);
+
+                THEN("border edges take the triangle's own far vertex") {
+
+                    expectedIndexes = {
+                        0, 2, 1, 3, 2, 1,
+                        2, 0, 1, 2, 3, 1,
+                    };
+                    CHECK(indexes == expectedIndexes);
+                }
+            }
+        }
+
+        GIVEN("three triangles sharing an edge") {
+
+            triangles.push_back(uvec3(0, 1, 2));
+            triangles.push_back(uvec3(1, 0, 3));
+            triangles.push_back(uvec3(0, 1, 4));
+
+            WHEN("generating triangles adjacency index") {
+
+                generateTrianglesAdjacencyIndex(triangles, indexes);
+
+                THEN("there are still 6 indexes per triangle, the shared edge pairs with the first other triangle") {
+
+                    REQUIRE(indexes.size() == 18);
+                    CHECK(indexes[1] == 3);
+                    CHECK(indexes[7] == 2);
+                    CHECK(indexes[13] == 2);
+                }
+            }
+        }
+
+        GIVEN("a closed torus, large enough to be written by several threads") {
+
+            triangles = torus(300, 200);
+
+            WHEN("generating triangles adjacency index") {
+
+                generateTrianglesAdjacencyIndex(triangles, indexes);
+                referenceAdjacencyIndex(triangles, expectedIndexes);
+
+                THEN("it matches the reference") {
+
+                    REQUIRE(indexes.size() == triangles.size() * 6);
+                    CHECK(indexes == expectedIndexes);
+                }
+            }
+        }
+
+        GIVEN("many separate triangles, every edge open") {
+
+            for (unsigned int t = 0; t < 30000; t ++) {
+                triangles.push_back(uvec3(t * 3, t * 3 + 1, t * 3 + 2));
+            }
+
+            WHEN("generating triangles adjacency index") {
+
+                generateTrianglesAdjacencyIndex(triangles, indexes);
+
+                THEN("each triangle only meets itself") {
+
+                    REQUIRE(indexes.size() == triangles.size() * 6);
+                    unsigned int wrong = 0;
+                    for (unsigned int t = 0; t < triangles.size(); t ++) {
+                        for (unsigned int i = 0; i < 3; i ++) {
+                            if (indexes[t * 6 + i * 2 + 1] != triangles[t][(i + 2) % 3]) wrong ++;
+                        }
+                    }
+                    CHECK(wrong == 0);
+                }
+            }
+        }
+
+        GIVEN("indexes already holding values") {
+
+            triangles = torus(4, 4);
+            indexes = {7, 7};
+
+            WHEN("generating triangles adjacency index") {
+
+                generateTrianglesAdjacencyIndex(triangles, indexes);
+
+                THEN("they are appended") {
+
+                    CHECK(indexes.size() == 2 + triangles.size() * 6);
+                    CHECK(indexes[0] == 7);
+                    CHECK(indexes[2] == triangles[0].x);
+                }
+            }
+        }
+    }
+
+    SCENARIO("Manifold adjacency throughput", "[.benchmark]") {
+
+        GIVEN("a 1M triangles torus") {
+
+            vector<uvec3> triangles = torus(1000, 500);
+
+            THEN("the edge table is timed against the former implementation") {
+
+                vector<unsigned int> reference;
+                auto start = chrono::high_resolution_clock::now();
+                referenceAdjacencyIndex(triangles, reference);
+                auto former = chrono::high_resolution_clock::now() - start;
+
+                vector<unsigned int> indexes;
+                start = chrono::high_resolution_clock::now();
+                generateTrianglesAdjacencyIndex(triangles, indexes);
+                auto hashed = chrono::high_resolution_clock::now() - start;
+
+                info("1M triangles, per vertex lists:", chrono::duration<double, milli>(former).count(), "ms");
+                info("1M triangles, edge table:      ", chrono::duration<double, milli>(hashed).count(), "ms");
+
+                CHECK(indexes == reference);
+            }
+        }
     }
 }
@@ -0,0 +1,169 @@
+#include "catch.hpp"
+#include "../../../src/utils/MeshCooker.hpp"
+#include "../../../src/utils/MappedFile.hpp"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace glm;
+
+namespace
+{
+    void writeFile(const string& filename, const string& content)
+    {
+        ofstream file(filename, ios::binary | ios::trunc);
+        file << content;
+    }
+
+    SCENARIO("MappedFile maps a file read only") {
+
+        GIVEN("a file") {
+
+            const string filename = "/tmp/tinyworld_test_mapped.txt";
+            writeFile(filename, "mapped");
+            MappedFile mapping;
+
+            THEN("its bytes can be read") {
+
+                REQUIRE(mapping.open(filename));
+                REQUIRE(mapping.size() == 6);
+                CHECK(string(reinterpret_cast<const char*>(mapping.data()), mapping.size()) == "mapped");
+            }
+
+            WHEN("the file is empty") {
+
+                writeFile(filename, "");
+
+                THEN("it opens with nothing to read") {
+
+                    CHECK(mapping.open(filename));
+                    CHECK(mapping.size() == 0);
+                }
+            }
+
+            THEN("a missing file can't be opened") {
+
+                CHECK_FALSE(mapping.open("/tmp/tinyworld_test_mapped.missing"));
+                CHECK(mapping.size() == 0);
+            }
+
+            remove(filename.c_str());
+        }
+    }
+
+    SCENARIO("loadCookedMesh maps the copy written by writeCookedMesh") {
+
+        GIVEN("a source file and the streams made from it") {
+
+            const string filename = "/tmp/tinyworld_test_mesh.obj";
+            const string cooked = filename + ".cooked";
+            writeFile(filename, "v 0 0 0\n");
+            remove(cooked.c_str());
+
+            const vector<vec4> vertexes {vec4(0.f, 0.f, 0.f, 1.f), vec4(1.f, 0.f, 0.f, 1.f), vec4(0.f, 1.f, 0.f, 1.f)};
+            const vector<vec2> uvs {vec2(0.f), vec2(1.f, 0.f), vec2(0.f, 1.f)};
+            const vector<vec3> normals(3, vec3(0.f, 0.f, 1.f));
+            const vector<vec3> tangents(3, vec3(1.f, 0.f, 0.f));
+            const vector<vec3> bitangents(3, vec3(0.f, 1.f, 0.f));
+            const vector<unsigned int> indexes {0, 1, 2};
+            const vector<unsigned int> adjacencyIndexes {0, 0, 1, 1, 2, 2};
+            const vector<unsigned int> lodIndexes {0, 2, 1};
+
+            MeshStreams streams;
+            streams.vertexes = vertexes;
+            streams.uvs = uvs;
+            streams.normals = normals;
+            streams.tangents = tangents;
+            streams.bitangents = bitangents;
+            streams.lods.resize(2);
+            streams.lods[0].indexes = indexes;
+            streams.lods[0].adjacencyIndexes = adjacencyIndexes;
+            streams.lods[1].indexes = lodIndexes;
+            streams.lods[1].error = 0.25f;
+
+            MappedFile mapping;
+            MeshStreams mapped;
+            uint64_t source = 0;
+
+            THEN("without a cooked copy it fails and tells the source hash") {
+
+                CHECK_FALSE(loadCookedMesh(filename.c_str(), mapping, mapped, source));
+                CHECK(source != 0);
+            }
+
+            WHEN("the streams are cooked") {
+
+                loadCookedMesh(filename.c_str(), mapping, mapped, source);
+                writeCookedMesh(filename.c_str(), source, streams);
+
+                THEN("they are mapped back aligned and unchanged") {
+
+                    REQUIRE(loadCookedMesh(filename.c_str(), mapping, mapped, source));
+                    REQUIRE(mapped.vertexes.size() == 3);
+                    REQUIRE(mapped.lods.size() == 2);
+                    REQUIRE(mapped.lods[0].indexes.size() == 3);
+                    REQUIRE(mapped.lods[0].adjacencyIndexes.size() == 6);
+                    REQUIRE(mapped.lods[1].indexes.size() == 3);
+                    CHECK(mapped.lods[1].adjacencyIndexes.empty());
+                    CHECK(mapped.lods[0].error == 0.f);
+                    CHECK(mapped.lods[1].error == 0.25f);
+                    CHECK(reinterpret_cast<uintptr_t>(mapped.normals.data()) % 16 == 0);
+                    CHECK(reinterpret_cast<uintptr_t>(mapped.lods[0].indexes.data()) % 16 == 0);
+                    CHECK(reinterpret_cast<uintptr_t>(mapped.lods[1].indexes.data()) % 16 == 0);
+                    for (unsigned int i = 0; i < 3; i ++) {
+                        CHECK(mapped.vertexes[i] == vertexes[i]);
+                        CHECK(mapped.uvs[i] == uvs[i]);
+                        CHECK(mapped.normals[i] == normals[i]);
+                        CHECK(mapped.tangents[i] == tangents[i]);
+                        CHECK(mapped.bitangents[i] == bitangents[i]);
+                        CHECK(mapped.lods[0].indexes[i] == indexes[i]);
+                        CHECK(mapped.lods[1].indexes[i] == lodIndexes[i]);
+                    }
+                    for (unsigned int i = 0; i < 6; i ++) {
+                        CHECK(mapped.lods[0].adjacencyIndexes[i] == adjacencyIndexes[i]);
+                    }
+                }
+
+                AND_WHEN("the source changes") {
+
+                    writeFile(filename, "v 1 0 0\n");
+
+                    THEN("the copy is outdated") {
+
+                        CHECK_FALSE(loadCookedMesh(filename.c_str(), mapping, mapped, source));
+                    }
+                }
+
+                AND_WHEN("the copy is truncated") {
+
+                    ifstream file(cooked, ios::binary);
+                    string content((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+                    writeFile(cooked, content.substr(0, content.size() - 4));
+
+                    THEN("it isn't read past its end") {
+
+                        CHECK_FALSE(loadCookedMesh(filename.c_str(), mapping, mapped, source));
+                    }
+                }
+            }
+
+            WHEN("the streams don't have one item per vertex") {
+
+                loadCookedMesh(filename.c_str(), mapping, mapped, source);
+                streams.normals = Span<vec3>(normals.data(), 2);
+                writeCookedMesh(filename.c_str(), source, streams);
+
+                THEN("nothing is cooked") {
+
+                    CHECK_FALSE(loadCookedMesh(filename.c_str(), mapping, mapped, source));
+                }
+            }
+
+            mapping.close();
+            remove(filename.c_str());
+            remove(cooked.c_str());
+        }
+    }
+}
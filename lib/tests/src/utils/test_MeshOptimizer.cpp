@@ -0,0 +1,190 @@
+#include "catch.hpp"
+#include "../../../src/utils/MeshOptimizer.hpp"
+#include "../../../src/utils/OBJ.hpp"
+#include "../../../src/utils/Log.hpp"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace glm;
+
+namespace
+{
+    // A side x side grid of quads, its triangles in a scattered order
+    void grid(unsigned int side, vector<vec4>& positions, vector<unsigned int>& indexes)
+    {
+        for (unsigned int y = 0; y <= side; y ++) {
+            for (unsigned int x = 0; x <= side; x ++) {
+                positions.push_back(vec4(float(x), float(y), 0.f, 1.f));
+            }
+        }
+        vector<uvec3> triangles;
+        for (unsigned int y = 0; y < side; y ++) {
+            for (unsigned int x = 0; x < side; x ++) {
+                const unsigned int a = y * (side + 1) + x;
+                triangles.push_back(uvec3(a, a + 1, a + side + 1));
+                triangles.push_back(uvec3(a + 1, a + side + 2, a + side + 1));
+            }
+        }
+        for (unsigned int i = 0; i < triangles.size(); i ++) {
+            swap(triangles[i], triangles[(i * 7919u) % triangles.size()]);
+        }
+        for (auto& t : triangles) {
+            indexes.insert(indexes.end(), {t.x, t.y, t.z});
+        }
+    }
+
+    // Triangles as sorted vertex triples, to compare meshes whatever their order
+    vector<uvec3> sortedTriangles(const vector<unsigned int>& indexes, const vector<vec4>& positions)
+    {
+        vector<uvec3> triangles;
+        for (size_t i = 0; i + 2 < indexes.size(); i += 3) {
+            unsigned int t[3] {
+                unsigned(positions[indexes[i]].x) * 1000 + unsigned(positions[indexes[i]].y),
+                unsigned(positions[indexes[i + 1]].x) * 1000 + unsigned(positions[indexes[i + 1]].y),
+                unsigned(positions[indexes[i + 2]].x) * 1000 + unsigned(positions[indexes[i + 2]].y) };
+            sort(t, t + 3);
+            triangles.push_back(uvec3(t[0], t[1], t[2]));
+        }
+        sort(triangles.begin(), triangles.end(), [](const uvec3& a, const uvec3& b) {
+            return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+        });
+        return triangles;
+    }
+
+    SCENARIO("analyzeVertexCache simulates a FIFO cache") {
+
+        GIVEN("a single triangle") {
+
+            const vector<unsigned int> indexes {0, 1, 2};
+
+            THEN("every vertex is transformed once") {
+
+                const VertexCacheStatistics statistics = analyzeVertexCache(indexes, 3);
+                CHECK(statistics.acmr == Approx(3.f));
+                CHECK(statistics.atvr == Approx(1.f));
+            }
+        }
+
+        GIVEN("two triangles sharing an edge") {
+
+            const vector<unsigned int> indexes {0, 1, 2, 2, 1, 3};
+
+            THEN("the shared vertexes are reused") {
+
+                CHECK(analyzeVertexCache(indexes, 4).acmr == Approx(2.f));
+            }
+
+            THEN("a cache of a single entry only reuses the last vertex") {
+
+                CHECK(analyzeVertexCache(indexes, 4, 1).atvr == Approx(1.25f));
+            }
+        }
+    }
+
+    SCENARIO("MeshOptimizer reorders triangles and vertexes for the caches") {
+
+        GIVEN("a grid of scattered triangles") {
+
+            vector<vec4> positions;
+            vector<unsigned int> indexes;
+            grid(32, positions, indexes);
+            const vector<uvec3> triangles = sortedTriangles(indexes, positions);
+            const VertexCacheStatistics scattered = analyzeVertexCache(indexes, positions.size());
+
+            WHEN("optimizing it for the vertex cache") {
+
+                optimizeVertexCache(indexes, positions.size());
+                const VertexCacheStatistics optimized = analyzeVertexCache(indexes, positions.size());
+
+                THEN("the same triangles are reused far better") {
+
+                    CHECK(sortedTriangles(indexes, positions) == triangles);
+                    CHECK(optimized.acmr < scattered.acmr * 0.5f);
+                    CHECK(optimized.acmr < 1.f);
+                }
+
+                AND_WHEN("optimizing it for overdraw") {
+
+                    optimizeOverdraw(indexes, positions);
+
+                    THEN("the same triangles keep most of the reuse") {
+
+                        CHECK(sortedTriangles(indexes, positions) == triangles);
+                        CHECK(analyzeVertexCache(indexes, positions.size()).acmr <= optimized.acmr * 1.2f);
+                    }
+                }
+            }
+
+            WHEN("optimizing it for vertex fetches") {
+
+                const vector<unsigned int> remap = optimizeVertexFetch(indexes, positions.size());
+                remapVertexes(positions, remap);
+
+                THEN("vertexes are numbered in their first use order") {
+
+                    CHECK(sortedTriangles(indexes, positions) == triangles);
+                    unsigned int next = 0;
+                    bool ordered = true;
+                    for (unsigned int index : indexes) {
+                        ordered = ordered && index <= next;
+                        if (index == next) next ++;
+                    }
+                    CHECK(ordered);
+                    CHECK(next == positions.size());
+                }
+            }
+        }
+
+        GIVEN("an unused vertex") {
+
+            vector<unsigned int> indexes {3, 1, 2};
+
+            THEN("it goes last") {
+
+                const vector<unsigned int> remap = optimizeVertexFetch(indexes, 4);
+                CHECK(indexes == (vector<unsigned int> {0, 1, 2}));
+                CHECK(remap == (vector<unsigned int> {3, 1, 2, 0}));
+            }
+        }
+    }
+
+    SCENARIO("MeshOptimizer report on the shipped objects", "[.benchmark]") {
+
+        GIVEN("every object") {
+
+            const char* objects[] {"cube", "plan", "sphere", "teapot", "torus", "twisted-torus"};
+
+            THEN("ACMR and ATVR before and after are reported") {
+
+                for (const char* object : objects) {
+                    const string filename = string("lib/res/objects/") + object + ".obj";
+                    if (!ifstream(filename).good()) {
+                        warning("MeshOptimizer report: missing", filename);
+                        continue;
+                    }
+
+                    vector<uvec3> triangles;
+                    vector<vec4> vertexes;
+                    vector<vec2> uvs;
+                    vector<vec3> normals;
+                    vector<unsigned int> indexes;
+                    vector<unsigned int> sources;
+                    OBJ(triangles, vertexes, uvs, normals, indexes, sources).load(filename.c_str());
+
+                    const VertexCacheStatistics before = analyzeVertexCache(indexes, vertexes.size());
+                    optimizeVertexCache(indexes, vertexes.size());
+                    const VertexCacheStatistics cache = analyzeVertexCache(indexes, vertexes.size());
+                    optimizeOverdraw(indexes, vertexes);
+                    const VertexCacheStatistics after = analyzeVertexCache(indexes, vertexes.size());
+
+                    info(object, "ACMR", before.acmr, "->", cache.acmr, "->", after.acmr, "ATVR", before.atvr, "->", cache.atvr, "->", after.atvr);
+                    CHECK(after.acmr <= before.acmr);
+                }
+            }
+        }
+    }
+}
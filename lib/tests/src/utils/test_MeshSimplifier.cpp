@@ -0,0 +1,210 @@
+#include "catch.hpp"
+#include "../../../src/utils/MeshSimplifier.hpp"
+#include <glm/glm.hpp>
+#include <cmath>
+#include <set>
+#include <vector>
+
+using namespace std;
+using namespace glm;
+
+namespace
+{
+    struct Shape
+    {
+        vector<vec4> vertexes;
+        vector<vec3> normals;
+        vector<vec2> uvs;
+        vector<unsigned int> positions;
+        vector<unsigned int> indexes;
+
+        void vertex(const vec3& position, const vec3& normal)
+        {
+            positions.push_back(unsigned(vertexes.size()));
+            vertexes.push_back(vec4(position, 1.f));
+            normals.push_back(normal);
+            uvs.push_back(vec2(0.f));
+        }
+    };
+
+    // Closed sphere of rings x segments quads, with a vertex at each pole
+    Shape sphere(unsigned int rings, unsigned int segments)
+    {
+        Shape shape;
+        shape.vertex(vec3(0.f, 0.f, 1.f), vec3(0.f, 0.f, 1.f));
+        for (unsigned int r = 1; r < rings; r ++) {
+            const float theta = float(M_PI) * float(r) / float(rings);
+            for (unsigned int s = 0; s < segments; s ++) {
+                const float phi = 2.f * float(M_PI) * float(s) / float(segments);
+                const vec3 p(sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta));
+                shape.vertex(p, p);
+            }
+        }
+        shape.vertex(vec3(0.f, 0.f, -1.f), vec3(0.f, 0.f, -1.f));
+
+        const unsigned int south = unsigned(shape.vertexes.size() - 1);
+        auto ring = [segments](unsigned int r, unsigned int s) { return 1 + (r - 1) * segments + s % segments; };
+        for (unsigned int s = 0; s < segments; s ++) {
+            shape.indexes.insert(shape.indexes.end(), {0, ring(1, s), ring(1, s + 1)});
+            shape.indexes.insert(shape.indexes.end(), {south, ring(rings - 1, s + 1), ring(rings - 1, s)});
+        }
+        for (unsigned int r = 1; r + 1 < rings; r ++) {
+            for (unsigned int s = 0; s < segments; s ++) {
+                shape.indexes.insert(shape.indexes.end(), {ring(r, s), ring(r + 1, s), ring(r + 1, s + 1)});
+                shape.indexes.insert(shape.indexes.end(), {ring(r, s), ring(r + 1, s + 1), ring(r, s + 1)});
+            }
+        }
+        return shape;
+    }
+
+    // Flat side x side grid of quads, its border is open
+    Shape grid(unsigned int side)
+    {
+        Shape shape;
+        for (unsigned int y = 0; y <= side; y ++) {
+            for (unsigned int x = 0; x <= side; x ++) {
+                shape.vertex(vec3(float(x), float(y), 0.f), vec3(0.f, 0.f, 1.f));
+            }
+        }
+        for (unsigned int y = 0; y < side; y ++) {
+            for (unsigned int x = 0; x < side; x ++) {
+                const unsigned int a = y * (side + 1) + x;
+                shape.indexes.insert(shape.indexes.end(), {a, a + 1, a + side + 2});
+                shape.indexes.insert(shape.indexes.end(), {a, a + side + 2, a + side + 1});
+            }
+        }
+        return shape;
+    }
+
+    bool valid(const vector<unsigned int>& indexes, const Shape& shape)
+    {
+        if (indexes.size() % 3 != 0) return false;
+        for (size_t i = 0; i < indexes.size(); i += 3) {
+            for (unsigned int j = 0; j < 3; j ++) {
+                if (indexes[i + j] >= shape.vertexes.size()) return false;
+            }
+            const unsigned int a = shape.positions[indexes[i]];
+            const unsigned int b = shape.positions[indexes[i + 1]];
+            const unsigned int c = shape.positions[indexes[i + 2]];
+            if (a == b || b == c || a == c) return false;
+        }
+        return true;
+    }
+
+    SCENARIO("simplifyMesh collapses edges down to a triangle count") {
+
+        GIVEN("a closed sphere") {
+
+            Shape shape = sphere(16, 32);
+            float error = 0.f;
+
+            WHEN("simplified to half its triangles") {
+
+                const vector<unsigned int> simplified = simplifyMesh(shape.indexes, shape.vertexes, shape.normals, shape.uvs, shape.positions, shape.indexes.size() / 2, error);
+
+                THEN("it keeps valid triangles, close to the original surface") {
+
+                    CHECK(simplified.size() <= shape.indexes.size() / 2);
+                    CHECK(simplified.size() > shape.indexes.size() / 4);
+                    CHECK(valid(simplified, shape));
+                    CHECK(error > 0.f);
+                    CHECK(error < 0.1f);
+                }
+            }
+
+            WHEN("simplified further") {
+
+                float halfError = 0.f;
+                simplifyMesh(shape.indexes, shape.vertexes, shape.normals, shape.uvs, shape.positions, shape.indexes.size() / 2, halfError);
+                const vector<unsigned int> simplified = simplifyMesh(shape.indexes, shape.vertexes, shape.normals, shape.uvs, shape.positions, shape.indexes.size() / 8, error);
+
+                THEN("the error grows") {
+
+                    CHECK(simplified.size() <= shape.indexes.size() / 8);
+                    CHECK(valid(simplified, shape));
+                    CHECK(error >= halfError);
+                }
+            }
+
+            WHEN("moved away from the origin") {
+
+                simplifyMesh(shape.indexes, shape.vertexes, shape.normals, shape.uvs, shape.positions, shape.indexes.size() / 2, error);
+                Shape moved = shape;
+                for (auto& vertex : moved.vertexes) vertex += vec4(3.f, 0.f, 0.f, 0.f);
+                float movedError = 0.f;
+                simplifyMesh(moved.indexes, moved.vertexes, moved.normals, moved.uvs, moved.positions, moved.indexes.size() / 2, movedError);
+
+                THEN("its error is relative to the radius around the origin") {
+
+                    CHECK(movedError == Approx(error / 4.f).epsilon(0.01));
+                }
+            }
+
+            WHEN("its target is already reached") {
+
+                const vector<unsigned int> simplified = simplifyMesh(shape.indexes, shape.vertexes, shape.normals, shape.uvs, shape.positions, shape.indexes.size(), error);
+
+                THEN("it is left as it is") {
+
+                    CHECK(simplified == shape.indexes);
+                    CHECK(error == 0.f);
+                }
+            }
+        }
+
+        GIVEN("a flat grid") {
+
+            Shape shape = grid(8);
+            float error = 1.f;
+            const vector<unsigned int> simplified = simplifyMesh(shape.indexes, shape.vertexes, shape.normals, shape.uvs, shape.positions, 0, error);
+
+            THEN("its inside is collapsed without error and its border stays") {
+
+                CHECK(simplified.size() < shape.indexes.size() / 2);
+                CHECK(valid(simplified, shape));
+                CHECK(error == Approx(0.f));
+
+                set<unsigned int> used(simplified.begin(), simplified.end());
+                for (unsigned int i = 0; i <= 8; i ++) {
+                    CHECK(used.count(i) == 1);
+                    CHECK(used.count(8 * 9 + i) == 1);
+                }
+            }
+        }
+
+        GIVEN("a sphere whose vertexes are split along a seam") {
+
+            Shape shape = sphere(8, 16);
+            // Every vertex of the first segment gets a twin with another normal, used by the triangles of the last segment
+            const size_t count = shape.vertexes.size();
+            vector<unsigned int> twins(count, ~0u);
+            for (unsigned int v = 1; v + 1 < count; v ++) {
+                if ((v - 1) % 16 != 0) continue;
+                twins[v] = unsigned(shape.vertexes.size());
+                shape.vertexes.push_back(shape.vertexes[v]);
+                shape.normals.push_back(-shape.normals[v]);
+                shape.uvs.push_back(vec2(1.f));
+                shape.positions.push_back(shape.positions[v]);
+            }
+            for (size_t i = 0; i < shape.indexes.size(); i += 3) {
+                bool last = false;
+                for (unsigned int j = 0; j < 3; j ++) {
+                    const unsigned int v = shape.indexes[i + j];
+                    last = last || (v > 0 && v + 1 < count && (v - 1) % 16 == 15);
+                }
+                for (unsigned int j = 0; j < 3 && last; j ++) {
+                    if (twins[shape.indexes[i + j]] != ~0u) shape.indexes[i + j] = twins[shape.indexes[i + j]];
+                }
+            }
+
+            float error = 0.f;
+            const vector<unsigned int> simplified = simplifyMesh(shape.indexes, shape.vertexes, shape.normals, shape.uvs, shape.positions, shape.indexes.size() / 2, error);
+
+            THEN("split vertexes move together and keep their side of the seam") {
+
+                CHECK(simplified.size() <= shape.indexes.size() / 2);
+                CHECK(valid(simplified, shape));
+            }
+        }
+    }
+}
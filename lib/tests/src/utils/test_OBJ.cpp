@@ -0,0 +1,304 @@
+#include "catch.hpp"
+#include "../../../src/utils/OBJ.hpp"
+#include "../../../src/utils/Log.hpp"
+#include <glm/glm.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace glm;
+
+namespace
+{
+    struct Parsed
+    {
+        vector<uvec3> triangles;
+        vector<vec4> vertexes;
+        vector<vec2> uvs;
+        vector<vec3> normals;
+        vector<unsigned int> indexes;
+        vector<unsigned int> positions;
+
+        void load(const string& filename, size_t chunkSize = OBJ::defaultChunkSize)
+        {
+            OBJ(triangles, vertexes, uvs, normals, indexes, positions).load(filename.c_str(), chunkSize);
+        }
+    };
+
+    void writeFile(const string& filename, const string& content)
+    {
+        ofstream file(filename, ios::binary | ios::trunc);
+        file << content;
+    }
+
+    // The stream based parser OBJ used to be, as a reference for the benchmark
+    void loadWithStreams(const char* filename, Parsed& parsed)
+    {
+        ifstream fin(filename);
+        vector<vec2> uvList;
+        vector<vec3> normalList;
+        while (!fin.eof()) {
+            char k[7] {' '};
+            fin >> k;
+            if (strncmp(k, "vt", 3) == 0) {
+                float u, v;
+                fin >> u >> v;
+                uvList.push_back(vec2(u, v));
+            } else if (strncmp(k, "vn", 3) == 0) {
+                float x, y, z;
+                fin >> x >> y >> z;
+                normalList.push_back(vec3(x, y, z));
+            } else if (strncmp(k, "v", 2) == 0) {
+                float x, y, z;
+                fin >> x >> y >> z;
+                parsed.vertexes.push_back(vec4(x, y, z, 1.f));
+            } else if (strncmp(k, "f", 2) == 0) {
+                unsigned int values[3] {0};
+                unsigned int face[3] {0};
+                for (unsigned int point = 0; point < 3; point ++) {
+                    for (unsigned int type = 0; type < 3; type ++) {
+                        fin >> values[type];
+                        fin.clear();
+                        fin.ignore();
+                    }
+                    face[point] = values[0] - 1;
+                    parsed.indexes.push_back(values[0] - 1);
+                    parsed.uvs.resize(parsed.vertexes.size());
+                    parsed.uvs[values[0] - 1] = uvList[values[1] - 1];
+                    parsed.normals.resize(parsed.vertexes.size());
+                    parsed.normals[values[0] - 1] = normalList[values[2] - 1];
+                }
+                parsed.triangles.push_back(uvec3(face[0], face[1], face[2]));
+            } else {
+                char c = ' ';
+                while (!fin.eof() && c != '\n') fin.read(&c, 1);
+            }
+        }
+    }
+
+    // A grid of quads cut in two triangles, faces count of them
+    void writeGrid(const string& filename, unsigned int faces)
+    {
+        const unsigned int side = unsigned(sqrt(faces / 2)) + 1;
+        ofstream file(filename, ios::binary | ios::trunc);
+        for (unsigned int y = 0; y <= side; y ++) {
+            for (unsigned int x = 0; x <= side; x ++) {
+                file << "v " << x * 0.01f << " " << y * 0.01f << " 0.0\n";
+            }
+        }
+        file << "vt 0.0 0.0\nvt 1.0 0.0\nvt 0.0 1.0\nvn 0.0 0.0 1.0\n";
+        unsigned int written = 0;
+        for (unsigned int y = 0; y < side && written < faces; y ++) {
+            for (unsigned int x = 0; x < side && written < faces; x ++, written += 2) {
+                const unsigned int a = y * (side + 1) + x + 1;
+                const unsigned int b = a + 1;
+                const unsigned int c = a + side + 1;
+                const unsigned int d = c + 1;
+                file << "f " << a << "/1/1 " << b << "/2/1 " << c << "/3/1\n";
+                file << "f " << b << "/2/1 " << d << "/1/1 " << c << "/3/1\n";
+            }
+        }
+    }
+
+    void benchmark(const string& name, const string& filename)
+    {
+        if (!ifstream(filename).good()) {
+            warning("OBJ benchmark: missing", filename);
+            return;
+        }
+
+        Parsed streams;
+        auto start = chrono::high_resolution_clock::now();
+        loadWithStreams(filename.c_str(), streams);
+        auto streamed = chrono::high_resolution_clock::now() - start;
+
+        Parsed chunks;
+        start = chrono::high_resolution_clock::now();
+        chunks.load(filename);
+        auto chunked = chrono::high_resolution_clock::now() - start;
+
+        info(name, "streams:", chrono::duration<double, milli>(streamed).count(), "ms,", streams.vertexes.size(), "vertexes");
+        info(name, "chunks: ", chrono::duration<double, milli>(chunked).count(), "ms,", chunks.vertexes.size(), "vertexes");
+
+        // The stream parser doesn't split vertexes, both still draw the same positions
+        REQUIRE(chunks.indexes.size() == streams.indexes.size());
+        bool same = true;
+        for (size_t i = 0; i < chunks.indexes.size(); i ++) {
+            same = same && chunks.vertexes[chunks.indexes[i]] == streams.vertexes[streams.indexes[i]];
+        }
+        CHECK(same);
+    }
+
+    SCENARIO("OBJ parses vertexes, uvs, normals and triangles") {
+
+        const string filename = "/tmp/tinyworld_test_obj.obj";
+
+        GIVEN("a file with two triangles sharing an edge") {
+
+            writeFile(filename,
+                "# comment\n"
+                "o quad\n"
+                "v 0.0 0.0 0.0\n"
+                "v 1.5 0 -2e-1\n"
+                "v 0 1.0 0\n"
+                "  v\t-1.0 1.0 +0.25\r\n"
+                "vt 0.0 0.0\n"
+                "vt 1.0 0.5\n"
+                "vn 0.0 0.0 1.0\n"
+                "vn 0.0 1.0 0.0\n"
+                "usemtl none\n"
+                "s off\n"
+                "f 1/1/1 2/2/1 3/1/1\n"
+                "f 3/2/2 2/1/2 4/2/2\n");
+            Parsed parsed;
+            parsed.load(filename);
+
+            THEN("every value is read") {
+
+                REQUIRE(parsed.vertexes.size() == 6);
+                CHECK(parsed.vertexes[1] == vec4(1.5f, 0.f, -0.2f, 1.f));
+                CHECK(parsed.vertexes[5] == vec4(-1.f, 1.f, 0.25f, 1.f));
+                REQUIRE(parsed.triangles.size() == 2);
+                CHECK(parsed.triangles[1] == uvec3(3, 4, 5));
+            }
+
+            THEN("positions used with different uvs or normals are split in several vertexes") {
+
+                REQUIRE(parsed.vertexes.size() == 6);
+                REQUIRE(parsed.uvs.size() == 6);
+                REQUIRE(parsed.normals.size() == 6);
+                CHECK(parsed.indexes == (vector<unsigned int> {0, 1, 2, 3, 4, 5}));
+                CHECK(parsed.positions == (vector<unsigned int> {0, 1, 2, 2, 1, 3}));
+                CHECK(parsed.vertexes[2] == parsed.vertexes[3]);
+                CHECK(parsed.uvs[2] == vec2(0.f, 0.f));
+                CHECK(parsed.uvs[3] == vec2(1.f, 0.5f));
+                CHECK(parsed.normals[2] == vec3(0.f, 0.f, 1.f));
+                CHECK(parsed.normals[3] == vec3(0.f, 1.f, 0.f));
+            }
+
+            WHEN("it is parsed in chunks of a few bytes") {
+
+                Parsed chunked;
+                chunked.load(filename, 7);
+
+                THEN("the result is the same") {
+
+                    CHECK(chunked.vertexes == parsed.vertexes);
+                    CHECK(chunked.uvs == parsed.uvs);
+                    CHECK(chunked.normals == parsed.normals);
+                    CHECK(chunked.indexes == parsed.indexes);
+                    CHECK(chunked.triangles == parsed.triangles);
+                    CHECK(chunked.positions == parsed.positions);
+                }
+            }
+        }
+
+        GIVEN("faces sharing their vertexes") {
+
+            writeFile(filename,
+                "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 1 1 0\nvt 0 0\nvn 0 0 1\n"
+                "f 1/1/1 2/1/1 3/1/1\n"
+                "f 3/1/1 2/1/1 4/1/1\n");
+            Parsed parsed;
+            parsed.load(filename);
+
+            THEN("each v/vt/vn triple is a single vertex") {
+
+                CHECK(parsed.vertexes.size() == 4);
+                CHECK(parsed.indexes == (vector<unsigned int> {0, 1, 2, 2, 1, 3}));
+            }
+        }
+
+        GIVEN("a quad, a pentagon and negative indexes") {
+
+            writeFile(filename,
+                "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+                "f 1 2 3 4\n"
+                "v 2 0 0\n"
+                "f -5 -4 -1 -3 -2\n");
+            Parsed parsed;
+            parsed.load(filename);
+
+            THEN("they are cut in fans of triangles") {
+
+                REQUIRE(parsed.triangles.size() == 5);
+                CHECK(parsed.positions == (vector<unsigned int> {0, 1, 2, 3, 4}));
+                CHECK(parsed.indexes == (vector<unsigned int> {0, 1, 2, 0, 2, 3, 0, 1, 4, 0, 4, 2, 0, 2, 3}));
+            }
+
+            WHEN("negative indexes point before the chunk they are in") {
+
+                Parsed chunked;
+                chunked.load(filename, 4);
+
+                THEN("the result is the same") {
+
+                    CHECK(chunked.indexes == parsed.indexes);
+                    CHECK(chunked.positions == parsed.positions);
+                }
+            }
+        }
+
+        GIVEN("points without uv nor normal and a face out of range") {
+
+            writeFile(filename,
+                "v 0 0 0\nv 1 0 0\nv 0 1 0\n"
+                "f 1 2 3\n"
+                "f 1//1 2//1 3//1\n"
+                "f 1 2 9\n");
+            Parsed parsed;
+            parsed.load(filename);
+
+            THEN("the missing values are zero and the broken face is skipped") {
+
+                CHECK(parsed.triangles.size() == 2);
+                CHECK(parsed.vertexes.size() == 3);
+                CHECK(parsed.uvs[0] == vec2(0.f));
+                CHECK(parsed.normals[0] == vec3(0.f));
+            }
+        }
+
+        GIVEN("floats written in many ways") {
+
+            writeFile(filename, "v 3.14159265 -0.000001 1E3\nv .5 -7. 12345678901234567890\nf 1 2 1\n");
+            Parsed parsed;
+            parsed.load(filename);
+
+            THEN("they are read as precisely as a float allows") {
+
+                REQUIRE(parsed.vertexes.size() == 2);
+                CHECK(parsed.vertexes[0].x == 3.14159265f);
+                CHECK(parsed.vertexes[0].y == -0.000001f);
+                CHECK(parsed.vertexes[0].z == 1000.f);
+                CHECK(parsed.vertexes[1].x == 0.5f);
+                CHECK(parsed.vertexes[1].y == -7.f);
+                CHECK(parsed.vertexes[1].z == Approx(1.2345678901234567e19f));
+            }
+        }
+
+        remove(filename.c_str());
+    }
+
+    SCENARIO("OBJ parsing throughput", "[.benchmark]") {
+
+        GIVEN("the shipped objects and a synthetic 10M faces object") {
+
+            const string synthetic = "/tmp/tinyworld_benchmark_obj.obj";
+            writeGrid(synthetic, 10000000);
+
+            THEN("parsing them with streams and in chunks is timed") {
+
+                benchmark("twisted-torus.obj", "lib/res/objects/twisted-torus.obj");
+                benchmark("teapot.obj", "lib/res/objects/teapot.obj");
+                benchmark("10M faces", synthetic);
+            }
+
+            remove(synthetic.c_str());
+        }
+    }
+}
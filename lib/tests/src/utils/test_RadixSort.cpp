@@ -0,0 +1,116 @@
+#include "catch.hpp"
+#include "../../../src/utils/RadixSort.hpp"
+#include "../../../src/utils/Log.hpp"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    SCENARIO("RadixSort sorts 64 bits keys along with their values") {
+
+        GIVEN("random keys spread over every byte") {
+
+            mt19937_64 generator(42);
+            vector<uint64_t> keys(10000);
+            vector<unsigned int> values(keys.size());
+            for (unsigned int i = 0; i < keys.size(); i ++) {
+                keys[i] = generator();
+                values[i] = i;
+            }
+            const vector<uint64_t> original(keys);
+
+            WHEN("sorting them") {
+
+                RadixSort().sort(keys, values);
+
+                THEN("they are in the same order as with std::sort") {
+
+                    vector<uint64_t> expected(original);
+                    sort(expected.begin(), expected.end());
+                    CHECK(keys == expected);
+                }
+
+                THEN("each value still goes with its key") {
+
+                    bool matching = true;
+                    for (unsigned int i = 0; i < keys.size(); i ++) {
+                        matching = matching && original[values[i]] == keys[i];
+                    }
+                    CHECK(matching);
+                }
+            }
+        }
+
+        GIVEN("keys with duplicates that only differ in their high byte") {
+
+            vector<uint64_t> keys {3ull << 56, 1ull << 56, 3ull << 56, 2ull << 56, 1ull << 56};
+            vector<unsigned int> values {0, 1, 2, 3, 4};
+
+            WHEN("sorting them") {
+
+                RadixSort().sort(keys, values);
+
+                THEN("equal keys keep their order") {
+
+                    CHECK(values == vector<unsigned int>({1, 4, 3, 0, 2}));
+                }
+            }
+        }
+
+        GIVEN("no keys") {
+
+            vector<uint64_t> keys;
+            vector<unsigned int> values;
+
+            WHEN("sorting them") {
+
+                RadixSort().sort(keys, values);
+
+                THEN("there is still nothing") {
+
+                    CHECK(keys.empty());
+                }
+            }
+        }
+    }
+
+    SCENARIO("RadixSort throughput", "[.benchmark]") {
+
+        GIVEN("1M draw keys") {
+
+            const unsigned int count = 1000000;
+            mt19937_64 generator(7);
+
+            // Draw keys only use a few of their high bits for the pass, program and mesh
+            vector<uint64_t> keys(count);
+            for (auto& key : keys) {
+                key = ((generator() & 0x3) << 56) | ((generator() & 0xF) << 40) | (generator() & 0xFFFFF);
+            }
+            vector<unsigned int> values(count);
+
+            THEN("sorting them is timed") {
+
+                vector<uint64_t> radixKeys(keys);
+                for (unsigned int i = 0; i < count; i ++) values[i] = i;
+                RadixSort radixSort;
+                auto start = chrono::high_resolution_clock::now();
+                radixSort.sort(radixKeys, values);
+                auto radix = chrono::high_resolution_clock::now() - start;
+
+                vector<uint64_t> stdKeys(keys);
+                start = chrono::high_resolution_clock::now();
+                sort(stdKeys.begin(), stdKeys.end());
+                auto standard = chrono::high_resolution_clock::now() - start;
+
+                info("1M keys, std::sort: ", chrono::duration<double, milli>(standard).count(), "ms");
+                info("1M keys, radix sort:", chrono::duration<double, milli>(radix).count(), "ms");
+
+                CHECK(radixKeys == stdKeys);
+            }
+        }
+    }
+}
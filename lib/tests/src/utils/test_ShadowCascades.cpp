@@ -0,0 +1,136 @@
+#include "catch.hpp"
+#include "../../../src/utils/ShadowCascades.hpp"
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+
+using namespace std;
+using namespace glm;
+
+namespace
+{
+    const vec3 light = normalize(vec3(1.f, 1.f, -0.3f));
+    const mat4 projection = infinitePerspective(float(M_PI) / 2.f, 4.f / 3.f, 0.5f);
+
+    mat4 camera(const vec3& position, float yaw)
+    {
+        return lookAt(position, position + vec3(cos(yaw), sin(yaw), -0.5f), vec3(0.f, 0.f, 1.f));
+    }
+
+    // Where a world point lands in the shadow map, in texels
+    vec2 texel(const ShadowCascade& cascade, const vec3& point, unsigned int resolution)
+    {
+        const vec4 projected = cascade.viewProjection * vec4(point, 1.f);
+        return vec2(projected.x, projected.y) * (float(resolution) * 0.5f);
+    }
+
+    SCENARIO("ShadowCascades split the view depths") {
+
+        float ends[4];
+
+        GIVEN("a uniform split") {
+
+            splitShadowCascades(1.f, 41.f, 4, 0.f, ends);
+
+            THEN("slices are as deep") {
+
+                CHECK(ends[0] == Approx(11.f));
+                CHECK(ends[1] == Approx(21.f));
+                CHECK(ends[2] == Approx(31.f));
+                CHECK(ends[3] == 41.f);
+            }
+        }
+
+        GIVEN("a logarithmic split") {
+
+            splitShadowCascades(1.f, 8.f, 3, 1.f, ends);
+
+            THEN("each slice ends twice as far") {
+
+                CHECK(ends[0] == Approx(2.f));
+                CHECK(ends[1] == Approx(4.f));
+                CHECK(ends[2] == 8.f);
+            }
+        }
+
+        GIVEN("a blended split") {
+
+            splitShadowCascades(0.5f, 40.f, 3, 0.75f, ends);
+
+            THEN("slices end in order, the last one at far") {
+
+                CHECK(ends[0] > 0.5f);
+                CHECK(ends[0] < ends[1]);
+                CHECK(ends[1] < ends[2]);
+                CHECK(ends[2] == 40.f);
+            }
+        }
+    }
+
+    SCENARIO("ShadowCascades fit the light around a slice of the view") {
+
+        const unsigned int resolution = 1024;
+
+        GIVEN("a cascade over a slice of the view frustum") {
+
+            const mat4 view = camera(vec3(3.f, -5.f, 5.f), 0.7f);
+            const ShadowCascade cascade = fitShadowCascade(view, projection, 2.f, 10.f, light, resolution);
+            const mat4 inverseView = inverse(view);
+
+            THEN("every corner of the slice is in the shadow map") {
+
+                const float depths[2] {2.f, 10.f};
+                for (float depth : depths) {
+                    for (unsigned int corner = 0; corner < 4; corner ++) {
+                        const vec3 local(
+                            (corner & 1 ? 1.f : -1.f) * depth / projection[0][0],
+                            (corner & 2 ? 1.f : -1.f) * depth / projection[1][1],
+                            -depth);
+                        const vec4 projected = cascade.viewProjection * inverseView * vec4(local, 1.f);
+                        CHECK(std::abs(projected.x) <= 1.f);
+                        CHECK(std::abs(projected.y) <= 1.f);
+                        CHECK(std::abs(projected.z) <= 1.f);
+                    }
+                }
+                CHECK(cascade.end == 10.f);
+            }
+
+            THEN("depth grows along the light") {
+
+                const vec3 point(inverseView * vec4(0.f, 0.f, -6.f, 1.f));
+                const vec4 near = cascade.viewProjection * vec4(point, 1.f);
+                const vec4 far = cascade.viewProjection * vec4(point + light, 1.f);
+                CHECK(far.z > near.z);
+            }
+        }
+
+        GIVEN("the camera turning in place") {
+
+            const ShadowCascade first = fitShadowCascade(camera(vec3(0.f, -5.f, 5.f), 0.f), projection, 2.f, 10.f, light, resolution);
+            const ShadowCascade turned = fitShadowCascade(camera(vec3(0.f, -5.f, 5.f), 1.3f), projection, 2.f, 10.f, light, resolution);
+
+            THEN("texels keep their size") {
+
+                CHECK(turned.texelSize == first.texelSize);
+                CHECK(turned.viewProjection[0][0] == Approx(first.viewProjection[0][0]));
+            }
+        }
+
+        GIVEN("the camera moving by less than a texel at a time") {
+
+            const vec3 point(4.f, 2.f, 0.f);
+            const ShadowCascade first = fitShadowCascade(camera(vec3(0.f, -5.f, 5.f), 0.4f), projection, 2.f, 10.f, light, resolution);
+
+            THEN("world points stay on the texel grid") {
+
+                for (unsigned int step = 1; step < 20; step ++) {
+                    const vec3 position = vec3(0.f, -5.f, 5.f) + vec3(0.013f, 0.007f, 0.f) * float(step);
+                    const ShadowCascade moved = fitShadowCascade(camera(position, 0.4f), projection, 2.f, 10.f, light, resolution);
+                    const vec2 offset = texel(moved, point, resolution) - texel(first, point, resolution);
+                    CHECK(offset.x == Approx(round(offset.x)).epsilon(0.01));
+                    CHECK(offset.y == Approx(round(offset.y)).epsilon(0.01));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,114 @@
+#include "catch.hpp"
+#include "../../../src/utils/ShadowCulling.hpp"
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace std;
+using namespace glm;
+
+namespace
+{
+    // Box frustum from -10 to 10 on every axis, planes pointing inside
+    void box(vec4 planes[6])
+    {
+        planes[0] = vec4(1.f, 0.f, 0.f, 10.f);
+        planes[1] = vec4(-1.f, 0.f, 0.f, 10.f);
+        planes[2] = vec4(0.f, 1.f, 0.f, 10.f);
+        planes[3] = vec4(0.f, -1.f, 0.f, 10.f);
+        planes[4] = vec4(0.f, 0.f, 1.f, 10.f);
+        planes[5] = vec4(0.f);
+    }
+
+    SCENARIO("ShadowCulling classifies shadow casters by where their volumes reach") {
+
+        vec4 planes[6];
+        box(planes);
+        const vec3 camera(0.f, 0.f, 5.f);
+        const vec3 down(0.f, 0.f, -1.f);
+
+        GIVEN("a caster inside the frustum, away from the camera") {
+
+            THEN("its volume is drawn with z-pass") {
+
+                CHECK(classifyShadowCaster(planes, camera, 0.5f, vec3(3.f, 0.f, 0.f), 1.f, down) == SHADOW_Z_PASS);
+            }
+        }
+
+        GIVEN("a caster outside of the frustum") {
+
+            THEN("it is culled when the light takes its volume further away") {
+
+                CHECK(classifyShadowCaster(planes, camera, 0.5f, vec3(20.f, 0.f, 0.f), 1.f, down) == SHADOW_CULLED);
+                CHECK(classifyShadowCaster(planes, camera, 0.5f, vec3(0.f, 0.f, -20.f), 1.f, down) == SHADOW_CULLED);
+            }
+
+            THEN("it is kept when the light brings its volume in") {
+
+                CHECK(classifyShadowCaster(planes, camera, 0.5f, vec3(20.f, 0.f, 0.f), 1.f, vec3(-1.f, 0.f, 0.f)) == SHADOW_Z_PASS);
+                CHECK(classifyShadowCaster(planes, camera, 0.5f, vec3(0.f, 20.f, 0.f), 1.f, vec3(0.f, -1.f, 0.f)) == SHADOW_Z_PASS);
+            }
+
+            THEN("the degenerate far plane is ignored") {
+
+                CHECK(classifyShadowCaster(planes, camera, 0.5f, vec3(0.f, 0.f, 200.f), 1.f, vec3(0.f, 0.f, 1.f)) == SHADOW_Z_PASS);
+            }
+        }
+
+        GIVEN("a caster above the camera") {
+
+            THEN("its volume contains the camera and needs z-fail") {
+
+                CHECK(classifyShadowCaster(planes, camera, 0.5f, vec3(0.f, 0.f, 8.f), 1.f, down) == SHADOW_Z_FAIL);
+                CHECK(classifyShadowCaster(planes, camera, 0.5f, vec3(1.2f, 0.f, 8.f), 1.f, down) == SHADOW_Z_FAIL);
+                CHECK(classifyShadowCaster(planes, camera, 0.5f, vec3(2.f, 0.f, 8.f), 1.f, down) == SHADOW_Z_PASS);
+            }
+        }
+
+        GIVEN("a caster below the camera") {
+
+            THEN("its volume goes away from the camera, unless the camera touches it") {
+
+                CHECK(classifyShadowCaster(planes, camera, 0.5f, vec3(0.f, 0.f, 2.f), 1.f, down) == SHADOW_Z_PASS);
+                CHECK(classifyShadowCaster(planes, camera, 0.5f, vec3(0.f, 0.f, 3.8f), 1.f, down) == SHADOW_Z_FAIL);
+            }
+        }
+    }
+
+    SCENARIO("ShadowCulling bounds shadow volumes on screen") {
+
+        const mat4 view = lookAt(vec3(0.f, 0.f, 10.f), vec3(0.f), vec3(0.f, 1.f, 0.f));
+        const mat4 viewProjection = perspective(1.5f, 1.f, 0.5f, 100.f) * view;
+
+        GIVEN("a small caster in front of the camera") {
+
+            WHEN("the light goes sideways, away from the camera") {
+
+                vec4 bounds;
+                const bool bounded = projectShadowVolume(viewProjection, vec3(0.f), 0.5f, normalize(vec3(1.f, 0.f, -1.f)), bounds);
+
+                THEN("its volume spans from the caster to the light's vanishing point") {
+
+                    REQUIRE(bounded);
+                    CHECK(bounds.x < 0.f);
+                    CHECK(bounds.z > 0.f);
+                    CHECK(bounds.y < 0.f);
+                    CHECK(bounds.w > 0.f);
+                    CHECK(bounds.w < 0.2f);
+
+                    const vec4 vanishing = viewProjection * vec4(normalize(vec3(1.f, 0.f, -1.f)), 0.f);
+                    CHECK(bounds.z == Approx(vanishing.x / vanishing.w));
+                }
+            }
+
+            WHEN("the light goes towards the camera") {
+
+                vec4 bounds;
+
+                THEN("the volume reaches behind it and isn't bounded") {
+
+                    CHECK(!projectShadowVolume(viewProjection, vec3(0.f), 0.5f, vec3(0.f, 0.f, 1.f), bounds));
+                }
+            }
+        }
+    }
+}
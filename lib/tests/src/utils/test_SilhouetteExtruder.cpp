@@ -0,0 +1,224 @@
+#include "catch.hpp"
+#include "../../../src/utils/SilhouetteExtruder.hpp"
+#include "../../../src/utils/Manifold.hpp"
+#include "../../../src/utils/Transforms.hpp"
+#include "../../../src/utils/Log.hpp"
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+using namespace std;
+using namespace glm;
+
+namespace
+{
+    // shadow_volume.geom run on the CPU, on vertexes already in world space
+    bool facesLight(const vec4& a, const vec4& b, const vec4& c, const vec3& light)
+    {
+        const vec3 normal = normalize(cross(vec3(a - b), vec3(c - b)));
+        return !(dot(normal, light) > 0.f);
+    }
+
+    vector<vec4> referenceSides(const vector<vec4>& world, const vector<unsigned int>& adjacency, const vec3& light)
+    {
+        vector<vec4> sides;
+        for (size_t t = 0; t + 5 < adjacency.size(); t += 6) {
+            const unsigned int* a = adjacency.data() + t;
+            if (!facesLight(world[a[0]], world[a[2]], world[a[4]], light)) continue;
+            for (int i = 0; i < 3; i ++) {
+                const vec4& v0 = world[a[(i * 2 + 2) % 6]];
+                const vec4& n0 = world[a[i * 2 + 1]];
+                const vec4& v1 = world[a[i * 2]];
+                if (facesLight(v0, n0, v1, light)) {
+                    sides.push_back(v0);
+                    sides.push_back(vec4(light, 0.f));
+                    sides.push_back(v1);
+                }
+            }
+        }
+        return sides;
+    }
+
+    // Closed torus of columns * rows quads, shared vertexes
+    void torus(unsigned int columns, unsigned int rows, vector<vec4>& positions, vector<unsigned int>& adjacency)
+    {
+        vector<uvec3> triangles;
+        for (unsigned int y = 0; y < rows; y ++) {
+            for (unsigned int x = 0; x < columns; x ++) {
+                const float u = float(x) / float(columns) * 6.2831853f;
+                const float v = float(y) / float(rows) * 6.2831853f;
+                positions.push_back(vec4((2.f + 0.7f * cos(v)) * cos(u), (2.f + 0.7f * cos(v)) * sin(u), 0.7f * sin(v), 1.f));
+
+                const unsigned int a = y * columns + x;
+                const unsigned int b = y * columns + (x + 1) % columns;
+                const unsigned int c = ((y + 1) % rows) * columns + x;
+                const unsigned int d = ((y + 1) % rows) * columns + (x + 1) % columns;
+                triangles.push_back(uvec3(a, b, c));
+                triangles.push_back(uvec3(b, d, c));
+            }
+        }
+        generateTrianglesAdjacencyIndex(triangles, adjacency);
+    }
+
+    vector<vec4> transform(const vector<vec4>& positions, const float* m)
+    {
+        vector<vec4> world;
+        for (auto& p : positions) {
+            world.push_back(vec4(
+                m[0] * p.x + m[1] * p.y + m[2] * p.z + m[3],
+                m[4] * p.x + m[5] * p.y + m[6] * p.z + m[7],
+                m[8] * p.x + m[9] * p.y + m[10] * p.z + m[11],
+                1.f));
+        }
+        return world;
+    }
+
+    SCENARIO("SilhouetteExtruder extrudes the silhouette edges the geometry shader would") {
+
+        GIVEN("a torus and instances turned, moved and scaled, mirrored by the last one") {
+
+            vector<vec4> positions;
+            vector<unsigned int> adjacency;
+            torus(24, 12, positions, adjacency);
+
+            ShadowCaster caster;
+            prepareShadowCaster(positions, adjacency, caster);
+
+            Transforms transforms;
+            transforms.add(vec3(0.f), quat(1.f, 0.f, 0.f, 0.f), vec3(1.f));
+            transforms.add(vec3(3.f, -1.f, 2.f), normalize(angleAxis(0.7f, normalize(vec3(1.f, 2.f, 0.5f)))), vec3(1.f, 3.f, 0.5f));
+            transforms.add(vec3(-2.f, 0.f, 1.f), normalize(angleAxis(2.1f, normalize(vec3(0.f, 1.f, 1.f)))), vec3(-1.5f, 1.f, 1.f));
+            vector<float> matrices(transforms.size() * Transforms::matrixFloats);
+            transforms.compose(matrices.data());
+
+            const vec3 light = normalize(vec3(1.f, 1.f, -0.3f));
+
+            THEN("each instance gets the reference sides, in the same order") {
+
+                for (unsigned int i = 0; i < transforms.size(); i ++) {
+                    const float* matrix = matrices.data() + i * Transforms::matrixFloats;
+                    const vector<vec4> expected = referenceSides(transform(positions, matrix), adjacency, light);
+
+                    vector<vec4> sides;
+                    extrudeSilhouette(caster, matrix, light, sides);
+
+                    REQUIRE(sides.size() == expected.size());
+                    CHECK(!sides.empty());
+                    for (size_t v = 0; v < sides.size(); v ++) {
+                        for (int c = 0; c < 4; c ++) {
+                            CHECK(sides[v][c] == Approx(expected[v][c]).epsilon(0.0001));
+                        }
+                    }
+                }
+            }
+        }
+
+        GIVEN("a torus extruded with caps") {
+
+            vector<vec4> positions;
+            vector<unsigned int> adjacency;
+            torus(16, 8, positions, adjacency);
+
+            ShadowCaster caster;
+            prepareShadowCaster(positions, adjacency, caster);
+            const float identity[12] {1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f};
+            const vec3 light = normalize(vec3(0.3f, 0.2f, -1.f));
+
+            vector<vec4> sides;
+            vector<vec4> volume;
+            extrudeSilhouette(caster, identity, light, sides);
+            extrudeSilhouette(caster, identity, light, volume, true);
+
+            THEN("the volume is closed, every edge is walked once each way") {
+
+                REQUIRE(volume.size() > sides.size());
+                vector<pair<vec4, vec4>> edges;
+                for (size_t v = 0; v < volume.size(); v += 3) {
+                    for (unsigned int i = 0; i < 3; i ++) {
+                        edges.push_back(make_pair(volume[v + i], volume[v + (i + 1) % 3]));
+                    }
+                }
+                unsigned int unmatched = 0;
+                for (auto& edge : edges) {
+                    unsigned int forward = 0;
+                    unsigned int backward = 0;
+                    for (auto& other : edges) {
+                        if (other.first == edge.first && other.second == edge.second) forward ++;
+                        if (other.first == edge.second && other.second == edge.first) backward ++;
+                    }
+                    if (forward != backward) unmatched ++;
+                }
+                CHECK(unmatched == 0);
+            }
+        }
+
+        GIVEN("a single triangle, its edges all on the border") {
+
+            const vector<vec4> positions {vec4(0.f, 0.f, 0.f, 1.f), vec4(1.f, 0.f, 0.f, 1.f), vec4(0.f, 1.f, 0.f, 1.f)};
+            vector<unsigned int> adjacency;
+            generateTrianglesAdjacencyIndex({uvec3(0, 1, 2)}, adjacency);
+
+            ShadowCaster caster;
+            prepareShadowCaster(positions, adjacency, caster);
+            const float identity[12] {1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f};
+
+            WHEN("it faces the light") {
+
+                vector<vec4> sides;
+                extrudeSilhouette(caster, identity, vec3(0.f, 0.f, 1.f), sides);
+
+                THEN("its 3 edges are extruded") {
+
+                    CHECK(sides.size() == 9);
+                    CHECK(sides == referenceSides(positions, adjacency, vec3(0.f, 0.f, 1.f)));
+                }
+            }
+
+            WHEN("it faces away from the light") {
+
+                vector<vec4> sides;
+                extrudeSilhouette(caster, identity, vec3(0.f, 0.f, -1.f), sides);
+
+                THEN("nothing is extruded") {
+
+                    CHECK(sides.empty());
+                }
+            }
+        }
+    }
+
+    SCENARIO("SilhouetteExtruder throughput", "[.benchmark]") {
+
+        GIVEN("1000 instances of a 20k triangles torus") {
+
+            vector<vec4> positions;
+            vector<unsigned int> adjacency;
+            torus(200, 50, positions, adjacency);
+
+            ShadowCaster caster;
+            prepareShadowCaster(positions, adjacency, caster);
+
+            Transforms transforms;
+            for (unsigned int i = 0; i < 1000; i ++) {
+                transforms.add(vec3(float(i % 32) * 6.f, float(i / 32) * 6.f, 0.f), normalize(angleAxis(float(i) * 0.1f, vec3(0.f, 0.f, 1.f))), vec3(1.f));
+            }
+            vector<float> matrices(transforms.size() * Transforms::matrixFloats);
+            transforms.compose(matrices.data());
+
+            THEN("extruding them is timed") {
+
+                vector<vec4> sides;
+                auto start = chrono::high_resolution_clock::now();
+                for (unsigned int i = 0; i < transforms.size(); i ++) {
+                    extrudeSilhouette(caster, matrices.data() + i * Transforms::matrixFloats, normalize(vec3(1.f, 1.f, -0.3f)), sides);
+                }
+                auto elapsed = chrono::high_resolution_clock::now() - start;
+
+                info("1000 instances, 20M triangles tested:", chrono::duration<double, milli>(elapsed).count(), "ms,", sides.size() / 3, "sides");
+                CHECK(!sides.empty());
+            }
+        }
+    }
+}
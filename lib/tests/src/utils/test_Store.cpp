@@ -117,4 +117,78 @@ namespace
             }
         }
     }
+
+    SCENARIO("Inserting items built elsewhere") {
+        GIVEN("a store with an item built by the store and one built outside") {
+
+            Store<std::string, Item, ItemData> items;
+            items.insert("first item", {.value = 111});
+            items.insert("second item", new Item({.value = 222}));
+
+            THEN("both items are stored in order") {
+                CHECK(items.size() == 2);
+                CHECK(items.getId("second item") == 1);
+                CHECK(items.get("second item").get()->value == 222);
+            }
+
+            WHEN("inserting a built item under a known key") {
+                items.insert("first item", new Item({.value = 111111}));
+
+                THEN("the first item is kept") {
+                    CHECK(items.size() == 2);
+                    CHECK(items.get("first item").get()->value == 111);
+                }
+            }
+        }
+    }
+
+    SCENARIO("Reserving items before they exist") {
+        GIVEN("a store with a reserved key") {
+
+            Store<std::string, Item, ItemData> items;
+            unsigned int id = items.reserve("late item");
+            items.insert("first item", {.value = 111});
+
+            THEN("the key has an id but no item yet") {
+                CHECK(id == 0);
+                CHECK(items.getId("late item") == 0);
+                CHECK_FALSE(items.getById(id));
+            }
+
+            WHEN("reserving it again") {
+                THEN("the id is the same") {
+                    CHECK(items.reserve("late item") == id);
+                    CHECK(items.size() == 2);
+                }
+            }
+
+            WHEN("inserting its item") {
+                items.insert("late item", new Item({.value = 222}));
+
+                THEN("it fills the reserved slot") {
+                    CHECK(items.size() == 2);
+                    CHECK(items.getById(id).get()->value == 222);
+                }
+            }
+        }
+    }
+
+    SCENARIO("Replacing items in place") {
+        GIVEN("a store with 2 items") {
+
+            Store<std::string, Item, ItemData> items;
+            items.insert("first item", {.value = 111});
+            items.insert("second item", {.value = 222});
+
+            WHEN("replacing the second one") {
+                items.replace(items.getId("second item"), new Item({.value = 333}));
+
+                THEN("its id is the same and its item is the new one") {
+                    CHECK(items.size() == 2);
+                    CHECK(items.getId("second item") == 1);
+                    CHECK(items.get("second item").get()->value == 333);
+                }
+            }
+        }
+    }
 }
@@ -0,0 +1,161 @@
+#include "catch.hpp"
+#include "../../../src/utils/TextureCooker.hpp"
+#include "lodepng.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    MipChain image(unsigned int width, unsigned int height, unsigned char value)
+    {
+        MipChain chain;
+        chain.width = width;
+        chain.height = height;
+        chain.levels.push_back(vector<unsigned char>(width * height * 4, value));
+        return chain;
+    }
+
+    SCENARIO("generateMipChain halves a texture down to 1x1") {
+
+        GIVEN("a 8x2 texture") {
+
+            MipChain chain = image(8, 2, 255);
+            generateMipChain(chain);
+
+            THEN("every level down to 1x1 is generated") {
+
+                REQUIRE(chain.levels.size() == 4);
+                CHECK(chain.levels[1].size() == 4 * 1 * 4);
+                CHECK(chain.levels[2].size() == 2 * 1 * 4);
+                CHECK(chain.levels[3].size() == 1 * 1 * 4);
+                CHECK(chain.levels[3][0] == 255);
+            }
+        }
+
+        GIVEN("a 2x1 texture, one black and one white texel") {
+
+            MipChain chain = image(2, 1, 0);
+            for (unsigned int c = 0; c < 4; c ++) chain.levels[0][4 + c] = 255;
+            generateMipChain(chain);
+
+            THEN("colors are averaged in linear space and alpha as it is") {
+
+                REQUIRE(chain.levels.size() == 2);
+                CHECK(chain.levels[1][0] == 188);
+                CHECK(chain.levels[1][1] == 188);
+                CHECK(chain.levels[1][2] == 188);
+                CHECK(chain.levels[1][3] == 128);
+            }
+        }
+
+        GIVEN("a 2x1 texture of data, one black and one white texel") {
+
+            MipChain chain = image(2, 1, 0);
+            for (unsigned int c = 0; c < 4; c ++) chain.levels[0][4 + c] = 255;
+            generateMipChain(chain, false);
+
+            THEN("every channel is averaged as it is") {
+
+                REQUIRE(chain.levels.size() == 2);
+                CHECK(chain.levels[1][0] == 128);
+                CHECK(chain.levels[1][1] == 128);
+                CHECK(chain.levels[1][2] == 128);
+                CHECK(chain.levels[1][3] == 128);
+            }
+        }
+
+        GIVEN("a 3x3 texture") {
+
+            MipChain chain = image(3, 3, 64);
+            generateMipChain(chain);
+
+            THEN("the odd row and column are repeated, a flat color stays the same") {
+
+                REQUIRE(chain.levels.size() == 2);
+                CHECK(chain.levels[1].size() == 4);
+                CHECK(chain.levels[1][0] == 64);
+            }
+        }
+    }
+
+    SCENARIO("loadCooked caches decoded textures") {
+
+        GIVEN("a PNG") {
+
+            const string filename = "/tmp/tinyworld_test_cooker.png";
+            const string cooked = filename + ".cooked";
+            remove(cooked.c_str());
+
+            vector<unsigned char> pixels(4 * 4 * 4, 200);
+            lodepng::encode(filename, pixels, 4, 4);
+
+            WHEN("loading it twice") {
+
+                MipChain first;
+                MipChain second;
+                REQUIRE(loadCooked(filename.c_str(), first, true));
+                REQUIRE(ifstream(cooked).good());
+                REQUIRE(loadCooked(filename.c_str(), second, true));
+
+                THEN("the cooked copy holds the same levels") {
+
+                    CHECK(first.width == 4);
+                    CHECK(first.height == 4);
+                    CHECK(first.levels.size() == 3);
+                    CHECK(second.width == first.width);
+                    CHECK(second.height == first.height);
+                    CHECK(second.levels == first.levels);
+                }
+            }
+
+            WHEN("the PNG changes after being cooked") {
+
+                MipChain chain;
+                REQUIRE(loadCooked(filename.c_str(), chain, true));
+                pixels.assign(2 * 2 * 4, 10);
+                lodepng::encode(filename, pixels, 2, 2);
+                REQUIRE(loadCooked(filename.c_str(), chain, true));
+
+                THEN("it is cooked again") {
+
+                    CHECK(chain.width == 2);
+                    CHECK(chain.levels[0][0] == 10);
+                }
+            }
+
+            WHEN("loading it as color and as data") {
+
+                MipChain color;
+                MipChain data;
+                REQUIRE(loadCooked(filename.c_str(), color, true, true));
+                REQUIRE(loadCooked(filename.c_str(), data, true, false));
+
+                THEN("each has its own cooked copy") {
+
+                    CHECK(ifstream(cooked).good());
+                    CHECK(ifstream(filename + ".linear.cooked").good());
+                }
+            }
+
+            WHEN("loading it without mip levels") {
+
+                MipChain chain;
+                REQUIRE(loadCooked(filename.c_str(), chain, false));
+
+                THEN("only the full size level is loaded") {
+
+                    CHECK(chain.levels.size() == 1);
+                }
+            }
+
+            remove(filename.c_str());
+            remove(cooked.c_str());
+            remove((filename + ".linear.cooked").c_str());
+            remove((filename + ".base.cooked").c_str());
+        }
+    }
+}
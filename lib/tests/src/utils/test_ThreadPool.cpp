@@ -0,0 +1,135 @@
+#include "catch.hpp"
+#include "../../../src/utils/ThreadPool.hpp"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    SCENARIO("ThreadPool runs queued tasks on its workers") {
+
+        GIVEN("a pool of 4 workers") {
+
+            ThreadPool pool(4);
+
+            THEN("it has 4 workers") {
+
+                CHECK(pool.size() == 4);
+            }
+
+            WHEN("queuing many tasks and waiting for them") {
+
+                atomic<unsigned int> count(0);
+                vector<unsigned int> results(1000, 0);
+                for (unsigned int i = 0; i < results.size(); i ++) {
+                    pool.enqueue([i, &count, &results]() {
+                        results[i] = i * 2;
+                        count ++;
+                    });
+                }
+                pool.wait();
+
+                THEN("every task has run once") {
+
+                    unsigned int wrong = 0;
+                    for (unsigned int i = 0; i < results.size(); i ++) {
+                        if (results[i] != i * 2) wrong ++;
+                    }
+                    CHECK(count == 1000);
+                    CHECK(wrong == 0);
+                }
+            }
+
+            WHEN("waiting with nothing queued") {
+
+                pool.wait();
+
+                THEN("it returns") {
+
+                    CHECK(true);
+                }
+            }
+        }
+
+        GIVEN("a pool of 1 worker kept busy") {
+
+            ThreadPool pool(1);
+            atomic<bool> released(false);
+            pool.enqueue([&released]() { while (!released) this_thread::yield(); }, ThreadPool::URGENT);
+
+            WHEN("queuing tasks of different priorities") {
+
+                mutex order;
+                string ran;
+                pool.enqueue([&order, &ran]() { lock_guard<mutex> lock(order); ran += 'b'; }, ThreadPool::BACKGROUND);
+                pool.enqueue([&order, &ran]() { lock_guard<mutex> lock(order); ran += 'n'; }, ThreadPool::NORMAL);
+                pool.enqueue([&order, &ran]() { lock_guard<mutex> lock(order); ran += 'u'; }, ThreadPool::URGENT);
+                released = true;
+                pool.wait();
+
+                THEN("the most urgent run first") {
+
+                    CHECK(ran == "unb");
+                }
+            }
+
+            WHEN("waiting for a group") {
+
+                ThreadPool::Group group;
+                atomic<unsigned int> count(0);
+                for (unsigned int i = 0; i < 10; i ++) {
+                    pool.enqueue([&count]() { count ++; }, ThreadPool::NORMAL, &group);
+                }
+                pool.wait(group);
+                const bool stillBusy = !released;
+                released = true;
+                pool.wait();
+
+                THEN("the waiting thread runs them without waiting for the others") {
+
+                    CHECK(count == 10);
+                    CHECK(stillBusy);
+                }
+            }
+
+            released = true;
+        }
+
+        GIVEN("a pool of 1 worker") {
+
+            ThreadPool pool(1);
+
+            WHEN("a task waits for the tasks it queues") {
+
+                atomic<unsigned int> count(0);
+                pool.enqueue([&pool, &count]() {
+                    ThreadPool::Group group;
+                    for (unsigned int i = 0; i < 10; i ++) {
+                        pool.enqueue([&count]() { count ++; }, ThreadPool::NORMAL, &group);
+                    }
+                    pool.wait(group);
+                });
+                pool.wait();
+
+                THEN("it runs them itself") {
+
+                    CHECK(count == 10);
+                }
+            }
+        }
+
+        GIVEN("a pool asked for no worker") {
+
+            ThreadPool pool(0);
+
+            THEN("it still has one") {
+
+                CHECK(pool.size() == 1);
+            }
+        }
+    }
+}
@@ -0,0 +1,181 @@
+#include "catch.hpp"
+#include "../../../src/utils/Transforms.hpp"
+#include "../../../src/utils/Log.hpp"
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <chrono>
+#include <vector>
+
+using namespace std;
+using namespace glm;
+
+namespace
+{
+    void fill(Transforms& transforms, unsigned int count)
+    {
+        for (unsigned int i = 0; i < count; i ++) {
+            float f = float(i);
+            transforms.add(
+                vec3(f, f * -0.5f, 2.f + f),
+                normalize(angleAxis(f * 0.3f, normalize(vec3(1.f, f, 2.f)))),
+                vec3(1.f + f * 0.1f, 2.f, 0.5f)
+            );
+        }
+    }
+
+    // Transform i as fill adds it, composed by glm
+    mat4 expected(unsigned int i)
+    {
+        float f = float(i);
+        return translate(mat4(1.f), vec3(f, f * -0.5f, 2.f + f))
+            * mat4_cast(normalize(angleAxis(f * 0.3f, normalize(vec3(1.f, f, 2.f)))))
+            * scale(mat4(1.f), vec3(1.f + f * 0.1f, 2.f, 0.5f));
+    }
+
+    bool matches(const vector<float>& matrices, unsigned int i)
+    {
+        const mat4 m = expected(i);
+        for (unsigned int row = 0; row < 3; row ++) {
+            for (unsigned int column = 0; column < 4; column ++) {
+                if (matrices[i * Transforms::matrixFloats + row * 4 + column] != Approx(m[int(column)][int(row)]).epsilon(0.0001)) return false;
+            }
+        }
+        return true;
+    }
+
+    SCENARIO("Transforms compose translation, rotation and scale into 3x4 matrices") {
+
+        GIVEN("11 transforms, enough to use every SIMD path and the scalar tail") {
+
+            Transforms transforms;
+            fill(transforms, 11);
+
+            WHEN("composing them") {
+
+                vector<float> matrices(transforms.size() * Transforms::matrixFloats);
+                transforms.compose(matrices.data());
+
+                THEN("each matrix is the transposed translation * rotation * scale product") {
+
+                    for (unsigned int i = 0; i < transforms.size(); i ++) {
+                        CHECK(matches(matrices, i));
+                    }
+                }
+            }
+
+            WHEN("composing them with and without AVX") {
+
+                vector<float> avxMatrices(transforms.size() * Transforms::matrixFloats);
+                vector<float> sseMatrices(transforms.size() * Transforms::matrixFloats);
+                vector<float> scalarMatrices(transforms.size() * Transforms::matrixFloats);
+                if (Transforms::hasAVX()) transforms.compose(avxMatrices.data(), true);
+                transforms.compose(sseMatrices.data(), false);
+                transforms.composeScalar(scalarMatrices.data());
+
+                THEN("every path gives the same result") {
+
+                    if (!Transforms::hasAVX()) WARN("AVX is not supported here, its path is not tested");
+                    for (unsigned int i = 0; i < scalarMatrices.size(); i ++) {
+                        if (Transforms::hasAVX()) CHECK(avxMatrices[i] == Approx(scalarMatrices[i]));
+                        CHECK(sseMatrices[i] == Approx(scalarMatrices[i]));
+                    }
+                }
+            }
+
+        }
+
+        GIVEN("3 transforms, fewer than a SIMD register holds") {
+
+            Transforms transforms;
+            fill(transforms, 3);
+
+            WHEN("composing them") {
+
+                vector<float> matrices(transforms.size() * Transforms::matrixFloats);
+                transforms.compose(matrices.data());
+
+                THEN("the scalar tail alone gives every matrix") {
+
+                    for (unsigned int i = 0; i < transforms.size(); i ++) {
+                        CHECK(matches(matrices, i));
+                    }
+                }
+            }
+        }
+
+        GIVEN("transforms gathered in another order") {
+
+            Transforms transforms;
+            fill(transforms, 5);
+            Transforms gathered;
+            gathered.gather(transforms, {4, 0, 2});
+
+            THEN("they hold the selected transforms in that order") {
+
+                CHECK(gathered.size() == 3);
+                CHECK(gathered.getPosition(0) == transforms.getPosition(4));
+                CHECK(gathered.getPosition(1) == transforms.getPosition(0));
+                CHECK(gathered.getPosition(2) == transforms.getPosition(2));
+            }
+        }
+
+        GIVEN("cleared transforms") {
+
+            Transforms transforms;
+            fill(transforms, 3);
+            transforms.clear();
+
+            THEN("there is nothing to compose") {
+
+                CHECK(transforms.size() == 0);
+            }
+        }
+    }
+
+    SCENARIO("Transforms composing throughput", "[.benchmark]") {
+
+        GIVEN("100k transforms") {
+
+            const unsigned int count = 100000;
+            const unsigned int runs = 50;
+
+            Transforms transforms;
+            fill(transforms, count);
+            vector<float> matrices(count * Transforms::matrixFloats);
+            vector<mat4> products(count);
+
+            THEN("composing them is timed") {
+
+                auto start = chrono::high_resolution_clock::now();
+                for (unsigned int run = 0; run < runs; run ++) {
+                    for (unsigned int i = 0; i < count; i ++) {
+                        float f = float(i);
+                        products[i] = translate(mat4(1.f), vec3(f, f * -0.5f, 2.f + f))
+                            * mat4_cast(angleAxis(f * 0.3f, vec3(1.f, 0.f, 0.f)))
+                            * scale(mat4(1.f), vec3(1.f + f * 0.1f, 2.f, 0.5f));
+                    }
+                }
+                auto matrixProducts = chrono::high_resolution_clock::now() - start;
+
+                start = chrono::high_resolution_clock::now();
+                for (unsigned int run = 0; run < runs; run ++) {
+                    transforms.composeScalar(matrices.data());
+                }
+                auto scalar = chrono::high_resolution_clock::now() - start;
+
+                start = chrono::high_resolution_clock::now();
+                for (unsigned int run = 0; run < runs; run ++) {
+                    transforms.compose(matrices.data());
+                }
+                auto simd = chrono::high_resolution_clock::now() - start;
+
+                info("100k instances, mat4 products:", chrono::duration<double, milli>(matrixProducts).count() / runs, "ms");
+                info("100k instances, scalar compose:", chrono::duration<double, milli>(scalar).count() / runs, "ms");
+                info("100k instances, SIMD compose:  ", chrono::duration<double, milli>(simd).count() / runs, "ms");
+
+                CHECK(products.size() == count);
+            }
+        }
+    }
+}